@@ -0,0 +1,465 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarks.cpp
+// ========
+// microbenchmarks for the CPU-side asset and math paths of Project1
+//
+// Every benchmark is timed in batches: the iteration count is doubled
+// until one batch takes at least MIN_BATCH_TIME, then BATCH_COUNT batches
+// are run and the median time per operation is kept, which shrugs off the
+// odd preempted batch.
+//
+// Results are written as JSON. Given a baseline file from an earlier run,
+// every benchmark slower than the baseline by more than the threshold is
+// reported and the process exits with a failure code, so a build script
+// can stop on regressions.
+//
+// Usage:
+//	Benchmarks [--out results.json] [--baseline baseline.json]
+//	           [--threshold 0.10] [--textures ../resources/textures]
+//	           [--filter name]
+//
+// No OpenGL context is created; only code that runs on the CPU is timed.
+// The texture cache benchmarks write .texcache entries next to the images,
+// as the renderer does, and the KTX2 ones read the TextureCooker's output,
+// skipping the textures that were not cooked.
+// Progress and the baseline comparison go to stderr, so the JSON can be
+// piped from stdout.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb-master/stb_image.h>
+#include <learnOpengl/camera.h>
+
+#include "meshes.h"
+#include "imageUtils.h"
+#include "transformStore.h"
+#include "textureCache.h"
+#include "compressedTexture.h"
+
+using namespace std;
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const std::chrono::milliseconds MIN_BATCH_TIME(20);
+	const int BATCH_COUNT = 9;
+
+	// Result of one benchmark
+	struct Result
+	{
+		string name;
+		double nsPerOp;
+		unsigned long long iterations;  // Per batch
+	};
+
+	// Keeps the optimizer from discarding work whose result is otherwise unused
+	volatile float gSink = 0.0f;
+
+	// The textures of the scene, as in Source.cpp
+	const char* const TEXTURE_FILES[] = {
+		"vanilla.jpg", "wood_table.jpg", "cork_texture.jpg", "label.jpg",
+		"bottle.jpg", "marble.jpg", "spoon.jpg"
+	};
+
+	// Square size decoded textures are scaled to, as TEXTURE_LAYER_SIZE in Source.cpp
+	const int TEXTURE_LAYER_SIZE = 1024;
+
+	///////////////////////////////////////////////////
+	//	Measure(const string&, function)
+	//
+	//	name: benchmark name in the report
+	//	body: runs the operation the given number of times
+	//
+	//	Calibrate a batch size, then return the median
+	//	time per operation over BATCH_COUNT batches
+	///////////////////////////////////////////////////
+	Result Measure(const string& name, const function<void(unsigned long long)>& body)
+	{
+		unsigned long long iterations = 1;
+		for (;;)
+		{
+			Clock::time_point start = Clock::now();
+			body(iterations);
+			if (Clock::now() - start >= MIN_BATCH_TIME || iterations >= (1ull << 40))
+				break;
+			iterations *= 2;
+		}
+
+		vector<double> samples;
+		for (int batch = 0; batch < BATCH_COUNT; ++batch)
+		{
+			Clock::time_point start = Clock::now();
+			body(iterations);
+			double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+			samples.push_back(ns / iterations);
+		}
+
+		nth_element(samples.begin(), samples.begin() + BATCH_COUNT / 2, samples.end());
+
+		Result result;
+		result.name = name;
+		result.nsPerOp = samples[BATCH_COUNT / 2];
+		result.iterations = iterations;
+		return result;
+	}
+
+	// Only benchmarks whose name contains this run, when set
+	const char* gFilter = NULL;
+
+	void Run(vector<Result>& results, const string& name, const function<void(unsigned long long)>& body)
+	{
+		if (gFilter && name.find(gFilter) == string::npos)
+			return;
+
+		results.push_back(Measure(name, body));
+		cerr << "INFO: " << name << " " << results.back().nsPerOp << " ns/op" << endl;
+	}
+
+	// Sphere and torus vertex building, without the GPU upload
+	void BenchmarkMeshes(vector<Result>& results)
+	{
+		Meshes meshes;
+
+		Run(results, "mesh_sphere_build", [&](unsigned long long n) {
+			for (unsigned long long i = 0; i < n; ++i)
+			{
+				Meshes::GLMesh mesh;
+				meshes.BuildSphereGeometry(mesh);
+				meshes.ClearStagedGeometry();
+				gSink = gSink + (float)mesh.nIndices;
+			}
+		});
+
+		Run(results, "mesh_torus_build", [&](unsigned long long n) {
+			for (unsigned long long i = 0; i < n; ++i)
+			{
+				Meshes::GLMesh mesh;
+				meshes.BuildTorusGeometry(mesh);
+				meshes.ClearStagedGeometry();
+				gSink = gSink + (float)mesh.nIndices;
+			}
+		});
+	}
+
+	// JPEG decoding of every scene texture, and the row flip applied after it
+	void BenchmarkImages(vector<Result>& results, const string& textureDirectory)
+	{
+		for (const char* file : TEXTURE_FILES)
+		{
+			string path = textureDirectory + "/" + file;
+
+			int width, height, channels;
+			unsigned char* image = stbi_load(path.c_str(), &width, &height, &channels, 0);
+			if (!image)
+			{
+				cerr << "WARNING: skipping " << path << " (cannot be decoded)" << endl;
+				continue;
+			}
+
+			Run(results, string("stbi_load_") + file, [&](unsigned long long n) {
+				for (unsigned long long i = 0; i < n; ++i)
+				{
+					int w, h, c;
+					unsigned char* decoded = stbi_load(path.c_str(), &w, &h, &c, 0);
+					gSink = gSink + (decoded ? decoded[0] : 0);
+					stbi_image_free(decoded);
+				}
+			});
+
+			Run(results, string("flip_vertical_") + file, [&](unsigned long long n) {
+				for (unsigned long long i = 0; i < n; ++i)
+					flipImageVertically(image, width, height, channels);
+				gSink = gSink + image[0];
+			});
+
+			stbi_image_free(image);
+		}
+	}
+
+	// The startup texture path of every scene texture: a cache hit (hash of
+	// the image file, then a mapping of the entry), the in-memory build of a
+	// miss and its scaling and mip steps, and the load of a cooked KTX2 file
+	void BenchmarkTextureLoads(vector<Result>& results, const string& textureDirectory)
+	{
+		for (const char* file : TEXTURE_FILES)
+		{
+			string path = textureDirectory + "/" + file;
+
+			// Also writes the cache entry the hit benchmark maps
+			CachedTexture warm;
+			if (!TextureCache::Load(path.c_str(), TEXTURE_LAYER_SIZE, warm, true))
+			{
+				cerr << "WARNING: skipping " << path << " (cannot be decoded)" << endl;
+				continue;
+			}
+
+			Run(results, string("texture_cache_hit_") + file, [&](unsigned long long n) {
+				for (unsigned long long i = 0; i < n; ++i)
+				{
+					CachedTexture texture;
+					TextureCache::Load(path.c_str(), TEXTURE_LAYER_SIZE, texture, true);
+					gSink = gSink + (float)texture.levels.size();
+				}
+			});
+
+			Run(results, string("texture_cache_build_") + file, [&](unsigned long long n) {
+				for (unsigned long long i = 0; i < n; ++i)
+				{
+					CachedTexture texture;
+					TextureCache::Load(path.c_str(), TEXTURE_LAYER_SIZE, texture, false);
+					gSink = gSink + (float)texture.levels.size();
+				}
+			});
+
+			int width, height, channels;
+			unsigned char* image = stbi_load(path.c_str(), &width, &height, &channels, 0);
+			if (image)
+			{
+				vector<unsigned char> scaled((size_t)TEXTURE_LAYER_SIZE * TEXTURE_LAYER_SIZE * channels);
+				Run(results, string("resample_1024_") + file, [&](unsigned long long n) {
+					for (unsigned long long i = 0; i < n; ++i)
+						resampleImage(image, width, height, channels, scaled.data(), TEXTURE_LAYER_SIZE, TEXTURE_LAYER_SIZE);
+					gSink = gSink + scaled[0];
+				});
+
+				vector<unsigned char> half(scaled.size() / 4);
+				Run(results, string("downsample_1024_") + file, [&](unsigned long long n) {
+					for (unsigned long long i = 0; i < n; ++i)
+						downsampleImage(scaled.data(), TEXTURE_LAYER_SIZE, TEXTURE_LAYER_SIZE, channels, half.data());
+					gSink = gSink + half[0];
+				});
+
+				stbi_image_free(image);
+			}
+
+			string cookedPath = CookedTexturePath(path.c_str());
+			CompressedTexture cooked;
+			if (!LoadKtx2(cookedPath.c_str(), cooked))
+			{
+				cerr << "WARNING: skipping " << cookedPath << " (not cooked)" << endl;
+				continue;
+			}
+
+			Run(results, string("ktx2_load_") + file, [&](unsigned long long n) {
+				for (unsigned long long i = 0; i < n; ++i)
+				{
+					CompressedTexture texture;
+					LoadKtx2(cookedPath.c_str(), texture);
+					gSink = gSink + (float)texture.levels.size();
+				}
+			});
+		}
+	}
+
+	// The camera calls made every frame and on every mouse move
+	void BenchmarkCamera(vector<Result>& results)
+	{
+		Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+		Run(results, "camera_view_matrix", [&](unsigned long long n) {
+			for (unsigned long long i = 0; i < n; ++i)
+			{
+				glm::mat4 view = camera.GetViewMatrix();
+				gSink = gSink + view[3][2];
+			}
+		});
+
+		Run(results, "camera_mouse_movement", [&](unsigned long long n) {
+			for (unsigned long long i = 0; i < n; ++i)
+				camera.ProcessMouseMovement((i & 1) ? 1.5f : -1.5f, (i & 2) ? 0.5f : -0.5f);
+			gSink = gSink + camera.Front.x;
+		});
+	}
+
+	// Model matrix composition: the original per-object glm path, and the
+	// transform store that replaced it in Render()
+	void BenchmarkTransforms(vector<Result>& results)
+	{
+		const glm::vec3 scale(0.3f, 0.06f, 0.3f);
+		const glm::vec3 axis(1.0f, 0.0f, 0.0f);
+		const glm::vec3 translation(0.0f, 0.42f, 0.5f);
+
+		Run(results, "glm_translate_rotate_scale", [&](unsigned long long n) {
+			for (unsigned long long i = 0; i < n; ++i)
+			{
+				float angle = (float)(i & 255) * 0.01f;
+				glm::mat4 model = glm::translate(translation) * glm::rotate(angle, axis) * glm::scale(scale);
+				gSink = gSink + model[3][1];
+			}
+		});
+
+		// Rebuild all 1000 transforms: every group dirty and a new view-projection
+		const size_t TRANSFORM_COUNT = 1000;
+		TransformStore store;
+		for (size_t i = 0; i < TRANSFORM_COUNT; ++i)
+			store.Add(translation + glm::vec3((float)i, 0.0f, 0.0f), 0.5f, axis, scale);
+
+		Run(results, "transform_store_update_1000", [&](unsigned long long n) {
+			for (unsigned long long i = 0; i < n; ++i)
+			{
+				for (TransformStore::Handle handle = 0; handle < TRANSFORM_COUNT; ++handle)
+					store.SetScale(handle, scale);
+				glm::mat4 viewProjection(1.0f);
+				viewProjection[3][0] = (float)(i & 255);
+				store.Update(viewProjection);
+			}
+			gSink = gSink + store.Matrices(0).mvp[3][0];
+		});
+	}
+
+	bool WriteJson(const vector<Result>& results, ostream& out)
+	{
+		out << "{\n  \"benchmarks\": [\n";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			out << "    { \"name\": \"" << results[i].name << "\", \"ns_per_op\": " << results[i].nsPerOp
+				<< ", \"iterations\": " << results[i].iterations << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n}\n";
+		return (bool)out;
+	}
+
+	///////////////////////////////////////////////////
+	//	ReadBaseline(const char*, vector<Result>&)
+	//
+	//	Read the name / ns_per_op pairs of a file
+	//	written by WriteJson(). Only that layout is
+	//	understood; this is not a general JSON parser.
+	///////////////////////////////////////////////////
+	bool ReadBaseline(const char* path, vector<Result>& baseline)
+	{
+		ifstream file(path);
+		if (!file)
+		{
+			cerr << "ERROR::BENCHMARKS::CANNOT_READ_BASELINE " << path << endl;
+			return false;
+		}
+
+		stringstream buffer;
+		buffer << file.rdbuf();
+		const string text = buffer.str();
+
+		size_t cursor = 0;
+		while ((cursor = text.find("\"name\"", cursor)) != string::npos)
+		{
+			size_t open = text.find('"', text.find(':', cursor) + 1);
+			size_t close = text.find('"', open + 1);
+			size_t value = text.find("\"ns_per_op\"", close);
+			if (open == string::npos || close == string::npos || value == string::npos)
+				break;
+
+			Result result;
+			result.name = text.substr(open + 1, close - open - 1);
+			result.nsPerOp = atof(text.c_str() + text.find(':', value) + 1);
+			result.iterations = 0;
+			baseline.push_back(result);
+
+			cursor = close;
+		}
+
+		return true;
+	}
+
+	// Print the comparison; returns the number of regressions
+	int Compare(const vector<Result>& results, const vector<Result>& baseline, double threshold)
+	{
+		int regressions = 0;
+		for (const Result& result : results)
+		{
+			auto match = find_if(baseline.begin(), baseline.end(), [&](const Result& b) { return b.name == result.name; });
+			if (match == baseline.end() || match->nsPerOp <= 0.0)
+			{
+				cerr << "  " << result.name << ": no baseline" << endl;
+				continue;
+			}
+
+			double change = result.nsPerOp / match->nsPerOp - 1.0;
+			bool regressed = change > threshold;
+			regressions += regressed ? 1 : 0;
+
+			cerr << (regressed ? "! " : "  ") << result.name << ": " << match->nsPerOp << " -> " << result.nsPerOp
+				<< " ns/op (" << (change >= 0.0 ? "+" : "") << change * 100.0 << "%)" << (regressed ? " REGRESSION" : "") << endl;
+		}
+		return regressions;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const char* outPath = NULL;
+	const char* baselinePath = NULL;
+	string textureDirectory = "../resources/textures";
+	double threshold = 0.10;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+			baselinePath = argv[++i];
+		else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+			threshold = atof(argv[++i]);
+		else if (strcmp(argv[i], "--textures") == 0 && i + 1 < argc)
+			textureDirectory = argv[++i];
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+			gFilter = argv[++i];
+		else
+		{
+			cerr << "Unknown argument " << argv[i] << endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	vector<Result> results;
+	BenchmarkMeshes(results);
+	BenchmarkImages(results, textureDirectory);
+	BenchmarkTextureLoads(results, textureDirectory);
+	BenchmarkCamera(results);
+	BenchmarkTransforms(results);
+
+	if (outPath)
+	{
+		ofstream file(outPath);
+		if (!file || !WriteJson(results, file))
+		{
+			cerr << "ERROR::BENCHMARKS::CANNOT_WRITE " << outPath << endl;
+			return EXIT_FAILURE;
+		}
+	}
+	else
+		WriteJson(results, cout);
+
+	if (baselinePath)
+	{
+		vector<Result> baseline;
+		if (!ReadBaseline(baselinePath, baseline))
+			return EXIT_FAILURE;
+
+		cerr << "INFO: Comparing against " << baselinePath << " (threshold " << threshold * 100.0 << "%)" << endl;
+		int regressions = Compare(results, baseline, threshold);
+		if (regressions > 0)
+		{
+			cerr << "ERROR::BENCHMARKS::" << regressions << " regression(s)" << endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -1,5 +1,13 @@
 ﻿#include <iostream>         // cout, cerr
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // memcpy, strcmp
+#include <vector>           // scene object list
+#include <algorithm>        // max
+#include <cmath>            // stress grid layout
+#include <chrono>           // benchmark timing
+#include <random>           // stress scene layout
+#include <mutex>            // texture decode hand-off
+#include <deque>            // decoded texture hand-off
 #include <GL/glew.h>        // GLEW library
 #include <GLFW/glfw3.h>     // GLFW library
 
@@ -12,6 +20,27 @@
 #include <stb-master/stb_image.h> // Image loading Utility functions
 #include <learnOpengl/camera.h>
 #include "meshes.h"
+#include "shaderProgram.h"
+#include "uniformBuffer.h"
+#include "glResources.h"
+#include "ringBuffer.h"
+#include "sceneData.h"
+#include "renderQueue.h"
+#include "transformStore.h"
+#include "framePacer.h"
+#include "gpuProfiler.h"
+#include "cpuProfiler.h"
+#include "headlessContext.h"
+#include "offscreenTarget.h"
+#include "glTrace.h"
+#include "inputLog.h"
+#include "gpuMemory.h"
+#include "startupTimeline.h"
+#include "perfHud.h"
+#include "threadPool.h"
+#include "textureStreamer.h"
+#include "compressedTexture.h"
+#include "textureCache.h"
 
 // Uses the standard namespace for debug output
 using namespace std;
@@ -34,16 +63,93 @@ namespace
 	// Main GLFW window
 	GLFWwindow* gWindow = nullptr;
 	// Shader program
-	GLuint gProgramId1;
-	GLuint gLampProgramId;
+	ShaderProgram gSurfaceProgram;
+
+	// Uniform handles for the surface shader, resolved once after linking
+	struct SurfaceUniforms
+	{
+		Uniform<int> texture;
+	};
+	SurfaceUniforms gSurfaceUniforms;
+
+	// Uniform buffer for the material table, and the CPU copy it is rewritten from
+	UniformBuffer gMaterialUniformBuffer;
+	GPUMaterialData gMaterialData = {};
+
+	// Persistently mapped ring for everything written per frame: frame
+	// uniforms, transform updates, instance data and indirect commands
+	const GLsizeiptr FRAME_RING_SIZE = 1024 * 1024;
+	RingBuffer gFrameRing;
+	GLint gUniformBufferAlignment = 256;
+
+	// Render queue batching the scene into instanced draws
+	RenderQueue gRenderQueue;
+
+	// World, normal and MVP matrices of every scene object
+	TransformStore gTransforms;
+
+	// Indices into the material table
+	enum MaterialId
+	{
+		MATERIAL_BOWL_BASE,
+		MATERIAL_BOWL,
+		MATERIAL_CORK,
+		MATERIAL_BOTTLE_NECK,
+		MATERIAL_BOTTLE,
+		MATERIAL_TABLE,
+		MATERIAL_ICE_CREAM,
+		MATERIAL_SPOON,
+		MATERIAL_SPOON_HANDLE,
+		MATERIAL_COUNT
+	};
+
+	// One object of the static scene: mesh parts drawn with one material and transform
+	struct SceneObject
+	{
+		const char* section;                    // Scene section the object belongs to
+		uint8_t sectionId;                      // Index into gSectionNames
+		const Meshes::GLMesh* mesh;
+		std::vector<Meshes::SubMesh> parts;     // Parts of the mesh to draw
+		MaterialId material;                    // Also picks the texture, see MATERIAL_TEXTURES
+		TransformStore::Handle transform;       // Entry in gTransforms
+
+		// Placement the transform was built from, reused by the stress benchmark
+		glm::vec3 scale;
+		float rotationAngle;
+		glm::vec3 rotationAxis;
+		glm::vec3 translation;
+	};
+	std::vector<SceneObject> gScene;
+	std::vector<SceneObject> gTableSet;     // The hand-built scene, kept as a template
+	std::vector<const char*> gSectionNames;
 	// Texture Ids
-	GLuint gTextureIdBlue;
-	GLuint gTextureIdRed;
-	GLuint gTextureIdBrown;
-	GLuint gTextureIdGreen;
-	GLuint gTextureIdYellow;
-	GLuint gTextureIdWhite;
-	GLuint gTextureIdSilver;
+	enum TextureId
+	{
+		TEXTURE_BLUE,
+		TEXTURE_RED,
+		TEXTURE_BROWN,
+		TEXTURE_GREEN,
+		TEXTURE_YELLOW,
+		TEXTURE_WHITE,
+		TEXTURE_SILVER,
+		TEXTURE_COUNT
+	};
+	// Array and layer of every texture; streaming moves them from the placeholder in place
+	TextureSlot gTextureSlots[TEXTURE_COUNT] = {};
+
+	// Texture of each material, indexed by MaterialId. Its layer is written into the
+	// material table, so objects with different textures still draw in one batch.
+	const TextureId MATERIAL_TEXTURES[MATERIAL_COUNT] = {
+		TEXTURE_WHITE,      // MATERIAL_BOWL_BASE
+		TEXTURE_WHITE,      // MATERIAL_BOWL
+		TEXTURE_BROWN,      // MATERIAL_CORK
+		TEXTURE_YELLOW,     // MATERIAL_BOTTLE_NECK
+		TEXTURE_GREEN,      // MATERIAL_BOTTLE
+		TEXTURE_RED,        // MATERIAL_TABLE
+		TEXTURE_BLUE,       // MATERIAL_ICE_CREAM
+		TEXTURE_SILVER,     // MATERIAL_SPOON
+		TEXTURE_SILVER,     // MATERIAL_SPOON_HANDLE
+	};
 
 	Meshes meshes;
 
@@ -51,15 +157,136 @@ namespace
 	Camera gCamera(glm::vec3(0.0f, 0.0f, 3.0f));
 	float gLastX = WINDOW_WIDTH / 2.0f;
 	float gLastY = WINDOW_HEIGHT / 2.0f;
-	glm::mat4 _Projection;
 	bool gFirstMouse = true;
 
 	// timing
 	float gDeltaTime = 0.0f; // time between current frame and last frame
 	float gLastFrame = 0.0f;
 
-	// Perspective flag
-	bool perspectiveMode = true;
+	// Frame pacing, chosen on the command line
+	FramePacer gFramePacer;
+	FramePacer::Mode gPacingMode = FramePacer::PACING_VSYNC;
+	double gTargetFps = 60.0;
+
+	// Seconds between frame-time reports
+	const double FRAME_REPORT_INTERVAL = 5.0;
+	double gLastFrameReport = 0.0;
+
+	// GPU time per scene section, enabled with --gpu-profile
+	GpuProfiler gGpuProfiler;
+	const char* gGpuProfilePath = NULL;
+
+	// CPU zone trace of a window of frames, enabled with --cpu-trace
+	const char* gCpuTracePath = NULL;
+	unsigned long long gCpuTraceFirstFrame = 120;
+	unsigned long long gCpuTraceFrameCount = 60;
+
+	// Headless runs (--headless --frames N) render a fixed number of frames
+	// into an offscreen framebuffer, stepping time by a constant amount
+	bool gHeadless = false;
+	unsigned long long gHeadlessFrames = 600;
+	const char* gHeadlessOutputPath = NULL;
+	const float HEADLESS_FRAME_TIME = 1.0f / 60.0f;
+	OffscreenTarget gOffscreenTarget;
+
+	// Far plane of the perspective projection; grows with the stress scene
+	float gFarPlane = 100.0f;
+
+	// CPU time of the last frame's submit, sort and execute, in milliseconds
+	double gLastSubmitMs = 0.0;
+
+	// GL call counters (--gl-stats) and the bytes the last frame streamed through the ring
+	bool gGlStats = false;
+	GLsizeiptr gLastStreamedBytes = 0;
+
+	// Scene-scaling benchmark (--stress): the table set is replicated into a
+	// grid of each tier's object count and measured for a number of frames
+	bool gStressBenchmark = false;
+	std::vector<size_t> gStressTiers = { 10, 100, 1000, 10000, 100000 };
+	int gStressFrames = 300;
+	const int STRESS_WARMUP_FRAMES = 30;
+	const float STRESS_SET_SPACING = 7.0f;
+	const unsigned int STRESS_SEED = 1234;
+
+	// Input recording (--record-input) and replay (--replay-input): a replayed
+	// run takes its keys, mouse events and time steps from the log
+	InputLog gInputLog;
+	const char* gRecordInputPath = NULL;
+	const char* gReplayInputPath = NULL;
+	InputLog::Frame gInputFrame;        // Frame being recorded or replayed
+	bool gDispatchingReplay = false;    // Callbacks are running replayed events
+
+	// Video memory budget in bytes (--vram-budget MB); a run that peaks above it fails
+	size_t gVramBudget = 0;
+
+	// Launch-to-first-frame timeline, printed once the first frame is presented.
+	// Constructed during static initialization, so it covers everything main() does.
+	StartupTimeline gStartup;
+	const char* gStartupReportPath = NULL;
+	double gStartupBudgetMs = 0.0;      // --startup-budget ms; a slower start fails the run
+	bool gStartupOverBudget = false;
+	bool gStartupAssetsReported = false;    // The report waits for every texture, past the first frame if need be
+
+	// On-screen performance overlay (--hud)
+	bool gHudEnabled = false;
+	PerfHud gHud;
+	ShaderProgram gHudProgram;
+
+	// Worker threads for CPU-only loading work (--worker-threads N, 0 for one per core)
+	ThreadPool gWorkers;
+	unsigned int gWorkerThreads = 0;
+
+	// The scene's texture files: read concurrently on the workers from the
+	// start of main(), then streamed by the main thread, in the order loads
+	// finish, into layers of array textures, one array per format and size;
+	// until its layer is in, each slot points at a 1x1 placeholder. A texture
+	// cooked by the TextureCooker is loaded from its .ktx2 file; any other goes
+	// through the decoded-texture cache, scaled to TEXTURE_LAYER_SIZE, so the
+	// image itself is only decoded when its cache entry is missing or stale.
+	// Each load is an asset of the startup report, from the worker's load to
+	// the layer swapping in, which may come after the first frame.
+	struct TextureLoad
+	{
+		const char* filename;
+		TextureSlot* slot;              // Pointed at the texture's layer once it is in
+		CompressedTexture cooked;
+		CachedTexture cached;
+		size_t asset;                   // Index in gStartup's assets
+		double loadStartMs;             // Set by the worker; a fallback load keeps the first start
+		double loadEndMs;
+		bool queued;                    // Handed to the streamer; waiting for its layer
+	};
+	std::vector<TextureLoad> gTextureLoads;
+	std::mutex gTextureLoadMutex;
+	std::deque<size_t> gDecodedTextures;    // Loads ready for upload
+	bool gTextureCacheEnabled = true;       // --no-texture-cache decodes every image on every run
+
+	// Decoded textures are all scaled to this square size so they share one array;
+	// the TextureCooker's post-build step cooks at the same --size
+	const GLsizei TEXTURE_LAYER_SIZE = 1024;
+
+	// Array textures of the scene, one per format and size, created when the first
+	// texture of that kind arrives with a layer for every file; and the placeholder
+	struct TextureArray
+	{
+		GLuint id;
+		GLenum internalFormat;
+		GLsizei width;
+		GLsizei height;
+		GLsizei levels;
+		GLint nextLayer;            // First layer not handed out yet
+	};
+	std::vector<TextureArray> gTextureArrays;
+	GLuint gPlaceholderArray = 0;
+
+	// Staging ring the texture levels are uploaded through, a budget of bytes per frame
+	TextureStreamer gTextureStreamer;
+	const GLsizeiptr TEXTURE_STAGING_SIZE = 32 * 1024 * 1024;
+	const GLsizeiptr TEXTURE_STREAM_BYTES_PER_FRAME = 8 * 1024 * 1024;
+	const unsigned char PLACEHOLDER_COLOR[4] = { 128, 128, 128, 255 };
+
+	// Keys polled by ProcessInput, in the bit order of InputLog::Frame::keys
+	const int RECORDED_KEYS[] = { GLFW_KEY_ESCAPE, GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_Q, GLFW_KEY_E };
 
 }
 
@@ -69,16 +296,40 @@ namespace
  * and render graphics on the screen
  */
 bool Initialize(int, char* [], GLFWwindow** window);
+bool InitializeWindow(GLFWwindow** window);
+bool ParseCommandLine(int argc, char* argv[]);
+void ReportFrameTimes();
+void FinishStartup();
+void ReportStartupAssets();
 void UResizeWindow(GLFWwindow* window, int width, int height);
 void ProcessInput(GLFWwindow* window);
+bool IsKeyPressed(GLFWwindow* window, int key);
+bool BeginInputFrame();
+void EndInputFrame();
+bool AcceptInputEvent(uint8_t type, double x, double y);
 void UMousePositionCallback(GLFWwindow* window, double xpos, double ypos);
 void UMouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 void UMouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void Render();
-bool CreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, GLuint& programId);
-void DestroyShaderProgram(GLuint programId);
-bool CreateTexture(const char* filename, GLuint& textureId);
-void DestroyTexture(GLuint textureId);
+void SubmitSceneObject(const SceneObject& object, const glm::mat4& view);
+void BuildScene();
+void BuildStressScene(size_t objectCount, std::mt19937& random);
+void RunStressBenchmark();
+bool ParseStressTiers(const char* list);
+bool CreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, ShaderProgram& program);
+void DestroyShaderProgram(ShaderProgram& program);
+void ResolveSurfaceUniforms();
+void CreateUniformBuffers();
+void DestroyUniformBuffers();
+void UpdateFrameUniforms(const glm::mat4& view, const glm::mat4& projection);
+void StartTextureDecodes();
+void SubmitTextureLoad(size_t index, bool useCooked);
+bool CreatePlaceholderTextures();
+void SetTextureArraySamplerState(GLuint array);
+void StreamDecodedTextures();
+GLuint AllocateTextureLayer(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei levels, GLint& layer);
+void UpdateMaterialTextures();
+void DestroyTexture(GLuint& textureId);
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -88,24 +339,54 @@ const GLchar* surfaceVertexShaderSource = GLSL(440,
 	layout(location = 0) in vec3 vertexPosition; // VAP position 0 for vertex position data
 layout(location = 1) in vec3 vertexNormal; // VAP position 1 for normals
 layout(location = 2) in vec2 textureCoordinate;
+layout(location = 3) in uint instanceTransform; // Per-instance index into the transform table
+layout(location = 4) in uint instanceMaterial; // Per-instance index into the material table
 
 out vec3 vertexFragmentNormal; // For outgoing normals to fragment shader
 out vec3 vertexFragmentPos; // For outgoing color / pixels to fragment shader
 out vec2 vertexTextureCoordinate;
+flat out uint vertexMaterialIndex;
 
-//Uniform / Global variables for the  transform matrices
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+struct Light
+{
+	vec4 position;
+	vec4 color;
+};
+
+// Per-frame data, written once per frame (must match GPUFrameData in sceneData.h)
+layout(std140, binding = 0) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	vec4 viewPosition;
+	vec4 ambientColor;
+	Light lights[2];
+};
+
+struct Transform
+{
+	mat4 world;
+	mat4 mvp;
+	mat3 normalMatrix;
+};
+
+// Matrices precomputed on the CPU (must match GPUTransform in sceneData.h)
+layout(std430, binding = 0) readonly buffer TransformData
+{
+	Transform transforms[];
+};
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(vertexPosition, 1.0f); // Transforms vertices into clip coordinates
+	Transform transform = transforms[instanceTransform];
+
+	gl_Position = transform.mvp * vec4(vertexPosition, 1.0f); // Transforms vertices into clip coordinates
 
-	vertexFragmentPos = vec3(model * vec4(vertexPosition, 1.0f)); // Gets fragment / pixel position in world space only (exclude view and projection)
+	vertexFragmentPos = vec3(transform.world * vec4(vertexPosition, 1.0f)); // Gets fragment / pixel position in world space only (exclude view and projection)
 
-	vertexFragmentNormal = mat3(transpose(inverse(model))) * vertexNormal; // get normal vectors in world space only and exclude normal translation properties
+	vertexFragmentNormal = transform.normalMatrix * vertexNormal; // get normal vectors in world space only and exclude normal translation properties
 	vertexTextureCoordinate = textureCoordinate;
+	vertexMaterialIndex = instanceMaterial;
 }
 );
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -116,72 +397,119 @@ const GLchar* surfaceFragmentShaderSource = GLSL(440,
 	in vec3 vertexFragmentNormal; // For incoming normals
 in vec3 vertexFragmentPos; // For incoming fragment position
 in vec2 vertexTextureCoordinate;
+flat in uint vertexMaterialIndex;
 
 out vec4 fragmentColor; // For outgoing cube color to the GPU
 
-// Uniform / Global variables for object color, light color, light position, and camera/view position
-uniform vec4 objectColor;
-uniform vec3 ambientColor;
-uniform vec3 light1Color;
-uniform vec3 light1Position;
-uniform vec3 light2Color;
-uniform vec3 light2Position;
-uniform vec3 viewPosition;
-uniform sampler2D uTexture; // Useful when working with multiple textures
-uniform vec2 uvScale;
-uniform bool ubHasTexture;
-uniform float ambientStrength = 0.1f; // Set ambient or global lighting strength
-uniform float specularIntensity1 = 0.8f;
-uniform float highlightSize1 = 16.0f;
-uniform float specularIntensity2 = 0.8f;
-uniform float highlightSize2 = 16.0f;
+struct Light
+{
+	vec4 position;
+	vec4 color;
+};
+
+struct Material
+{
+	vec4 objectColor;
+	vec2 uvScale;
+	float ambientStrength;
+	int textureLayer;
+	vec2 specularIntensity;
+	vec2 highlightSize;
+};
+
+// Per-frame data, written once per frame (must match GPUFrameData in sceneData.h)
+layout(std140, binding = 0) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	vec4 viewPosition;
+	vec4 ambientColor;
+	Light lights[2];
+};
+
+// Material table, rewritten as textures stream in (must match GPUMaterialData in sceneData.h)
+layout(std140, binding = 1) uniform MaterialData
+{
+	Material materials[16];
+};
+
+// Uniform / Global variables for the texture: every material texture is a layer of this array
+uniform sampler2DArray uTexture;
 
 void main()
 {
 	/*Phong lighting model calculations to generate ambient, diffuse, and specular components*/
+	Material material = materials[vertexMaterialIndex];
 
 	//Calculate Ambient lighting
-	vec3 ambient = ambientStrength * ambientColor; // Generate ambient light color
+	vec3 ambient = material.ambientStrength * ambientColor.rgb; // Generate ambient light color
 
-	//**Calculate Diffuse lighting**
-	vec3 norm = normalize(vertexFragmentNormal); // Normalize vectors to 1 unit
-	vec3 light1Direction = normalize(light1Position - vertexFragmentPos); // Calculate distance (light direction) between light source and fragments/pixels on cube
-	float impact1 = max(dot(norm, light1Direction), 0.0);// Calculate diffuse impact by generating dot product of normal and light
-	vec3 diffuse1 = impact1 * light1Color; // Generate diffuse light color
-	vec3 light2Direction = normalize(light2Position - vertexFragmentPos); // Calculate distance (light direction) between light source and fragments/pixels on cube
-	float impact2 = max(dot(norm, light2Direction), 0.0);// Calculate diffuse impact by generating dot product of normal and light
-	vec3 diffuse2 = impact2 * light2Color; // Generate diffuse light color
-
-	//**Calculate Specular lighting**
-	vec3 viewDir = normalize(viewPosition - vertexFragmentPos); // Calculate view direction
-	vec3 reflectDir1 = reflect(-light1Direction, norm);// Calculate reflection vector
-	//Calculate specular component
-	float specularComponent1 = pow(max(dot(viewDir, reflectDir1), 0.0), highlightSize1);
-	vec3 specular1 = specularIntensity1 * specularComponent1 * light1Color;
-	vec3 reflectDir2 = reflect(-light2Direction, norm);// Calculate reflection vector
-	//Calculate specular component
-	float specularComponent2 = pow(max(dot(viewDir, reflectDir2), 0.0), highlightSize2);
-	vec3 specular2 = specularIntensity2 * specularComponent2 * light2Color;
-
-	//**Calculate phong result**
 	//Texture holds the color to be used for all three components
-	vec4 textureColor = texture(uTexture, vertexTextureCoordinate * uvScale);
-	vec3 phong1;
-	vec3 phong2;
+	vec3 baseColor = material.objectColor.rgb;
+	if (material.textureLayer >= 0)
+		baseColor = texture(uTexture, vec3(vertexTextureCoordinate * material.uvScale, material.textureLayer)).rgb;
 
-	if (ubHasTexture == true)
-	{
-		phong1 = (ambient + diffuse1 + specular1) * textureColor.xyz;
-		phong2 = (ambient + diffuse2 + specular2) * textureColor.xyz;
-	}
-	else
+	vec3 norm = normalize(vertexFragmentNormal); // Normalize vectors to 1 unit
+	vec3 viewDir = normalize(viewPosition.xyz - vertexFragmentPos); // Calculate view direction
+	vec3 phong = vec3(0.0);
+
+	for (int i = 0; i < 2; ++i)
 	{
-		phong1 = (ambient + diffuse1 + specular1) * objectColor.xyz;
-		phong2 = (ambient + diffuse2 + specular2) * objectColor.xyz;
+		//**Calculate Diffuse lighting**
+		vec3 lightDirection = normalize(lights[i].position.xyz - vertexFragmentPos); // Calculate distance (light direction) between light source and fragments/pixels
+		float impact = max(dot(norm, lightDirection), 0.0);// Calculate diffuse impact by generating dot product of normal and light
+		vec3 diffuse = impact * lights[i].color.rgb; // Generate diffuse light color
+
+		//**Calculate Specular lighting**
+		vec3 reflectDir = reflect(-lightDirection, norm);// Calculate reflection vector
+		float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), material.highlightSize[i]);
+		vec3 specular = material.specularIntensity[i] * specularComponent * lights[i].color.rgb;
+
+		//**Calculate phong result**
+		phong += (ambient + diffuse + specular) * baseColor;
 	}
 
-	fragmentColor = vec4(phong1 + phong2, 1.0); // Send lighting results to GPU
-	//fragmentColor = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+	fragmentColor = vec4(phong, 1.0); // Send lighting results to GPU
+}
+);
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* Performance HUD Vertex Shader Source Code*/
+const GLchar* hudVertexShaderSource = GLSL(440,
+
+	layout(location = 0) in vec2 vertexPosition; // Pixels from the top-left corner
+layout(location = 1) in vec2 vertexAtlasCoordinate;
+layout(location = 2) in vec4 vertexColor;
+
+out vec2 atlasCoordinate;
+out vec4 overlayColor;
+
+uniform vec2 uViewportSize;
+
+void main()
+{
+	// Pixels to clip space, with y pointing down
+	vec2 clip = vertexPosition / uViewportSize * 2.0 - 1.0;
+	gl_Position = vec4(clip.x, -clip.y, 0.0, 1.0);
+	atlasCoordinate = vertexAtlasCoordinate;
+	overlayColor = vertexColor;
+}
+);
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* Performance HUD Fragment Shader Source Code*/
+const GLchar* hudFragmentShaderSource = GLSL(440,
+
+	in vec2 atlasCoordinate;
+in vec4 overlayColor;
+
+out vec4 fragmentColor;
+
+uniform sampler2D uAtlas; // One-channel font atlas with a solid cell
+
+void main()
+{
+	fragmentColor = vec4(overlayColor.rgb, overlayColor.a * texture(uAtlas, atlasCoordinate).r);
 }
 );
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -193,110 +521,444 @@ void main()
 // main function. Entry point to the OpenGL program //
 int main(int argc, char* argv[])
 {
-	if (!Initialize(argc, argv, &gWindow))
+	if (!ParseCommandLine(argc, argv))
 		return EXIT_FAILURE;
 
-	// Create the mesh, send data to VBO
-	meshes.CreateMeshes();
-
-	// Create the shader program
-	if (!CreateShaderProgram(surfaceVertexShaderSource, surfaceFragmentShaderSource, gProgramId1))
+	if (gReplayInputPath && !gInputLog.OpenForReplay(gReplayInputPath))
+		return EXIT_FAILURE;
+	if (gRecordInputPath && !gInputLog.OpenForRecording(gRecordInputPath))
 		return EXIT_FAILURE;
 
+	// Texture decoding needs no context, so it overlaps everything up to the upload
+	gWorkers.Create(gWorkerThreads, "Loader");
+	StartTextureDecodes();
 
-	//Load texture data from file
-	const char * texFilename1 = "../resources/textures/vanilla.jpg";
-	if (!CreateTexture(texFilename1, gTextureIdBlue))
-	{
-		cout << "Failed to load texture " << texFilename1 << endl;
+	PROFILE_THREAD("Main");
+	if (gCpuTracePath)
+		PROFILE_CAPTURE(gCpuTracePath, gCpuTraceFirstFrame, gCpuTraceFrameCount,
+			gHeadless && !gReplayInputPath && !gStressBenchmark ? gHeadlessFrames : 0);
+
+	size_t initializePhase = gStartup.BeginPhase("Initialize");
+	if (!Initialize(argc, argv, &gWindow))
 		return EXIT_FAILURE;
-	}
+	gStartup.EndPhase(initializePhase);
+
+	GpuMemory::SetBudget(gVramBudget);
+
+	// Count GL calls from the first one the renderer makes
+	if (gGlStats && !GlTrace::Install())
+		cout << "WARNING: built without the GL trace layer, --gl-stats is ignored" << endl;
 
-	texFilename1 = "../resources/textures/wood_table.jpg";
-	if (!CreateTexture(texFilename1, gTextureIdRed))
+	// Pace the loop explicitly instead of relying on the driver's default swap interval
+	gFramePacer.Configure(gPacingMode, gTargetFps, !gHeadless);
+
+	// Nothing is presented headless: every frame goes to the offscreen target
+	if (gHeadless)
 	{
-		cout << "Failed to load texture " << texFilename1 << endl;
-		return EXIT_FAILURE;
+		if (!gOffscreenTarget.Create(WINDOW_WIDTH, WINDOW_HEIGHT))
+			return EXIT_FAILURE;
+		gOffscreenTarget.Bind();
 	}
 
-	texFilename1 = "../resources/textures/cork_texture.jpg";
-	if (!CreateTexture(texFilename1, gTextureIdBrown))
-	{
-		cout << "Failed to load texture " << texFilename1 << endl;
+	// Create the mesh, send data to VBO
+	size_t meshesPhase = gStartup.BeginPhase("CreateMeshes");
+	meshes.CreateMeshes();
+	gStartup.EndPhase(meshesPhase);
+
+	// Create the shader program
+	size_t shaderPhase = gStartup.BeginPhase("CreateShaderProgram");
+	if (!CreateShaderProgram(surfaceVertexShaderSource, surfaceFragmentShaderSource, gSurfaceProgram))
 		return EXIT_FAILURE;
-	}
+	ResolveSurfaceUniforms();
+	gStartup.EndPhase(shaderPhase);
 
-	texFilename1 = "../resources/textures/label.jpg";
-	if (!CreateTexture(texFilename1, gTextureIdGreen))
-	{
-		cout << "Failed to load texture " << texFilename1 << endl;
+	// Create the material uniform buffer
+	size_t buffersPhase = gStartup.BeginPhase("CreateBuffers");
+	CreateUniformBuffers();
+
+	// Create the per-frame ring and the transform table
+	if (!gFrameRing.Create(FRAME_RING_SIZE))
 		return EXIT_FAILURE;
-	}
+	gTransforms.Create(TRANSFORM_DATA_BINDING);
+	gStartup.EndPhase(buffersPhase);
 
-	texFilename1 = "../resources/textures/bottle.jpg";
-	if (!CreateTexture(texFilename1, gTextureIdYellow))
+	// Time every scene section on the GPU; sections are then drawn one after another
+	if (gGpuProfilePath)
 	{
-		cout << "Failed to load texture " << texFilename1 << endl;
-		return EXIT_FAILURE;
+		gGpuProfiler.Create();
+		gRenderQueue.SetGrouping(true);
 	}
 
-	texFilename1 = "../resources/textures/marble.jpg";
-	if (!CreateTexture(texFilename1, gTextureIdWhite))
+	// The overlay shows the GPU frame time, so it needs the profiler too
+	if (gHudEnabled)
 	{
-		cout << "Failed to load texture " << texFilename1 << endl;
-		return EXIT_FAILURE;
+		if (!CreateShaderProgram(hudVertexShaderSource, hudFragmentShaderSource, gHudProgram) || !gHud.Create(gHudProgram))
+			return EXIT_FAILURE;
+		if (!gGpuProfiler.IsCreated())
+			gGpuProfiler.Create();
 	}
 
-	texFilename1 = "../resources/textures/spoon.jpg";
-	if (!CreateTexture(texFilename1, gTextureIdSilver))
-	{
-		cout << "Failed to load texture " << texFilename1 << endl;
+	// Draw with placeholders from the first frame; the real textures stream in as the workers decode them
+	size_t texturesPhase = gStartup.BeginPhase("CreateTextures");
+	if (!CreatePlaceholderTextures())
 		return EXIT_FAILURE;
-	}
+	gStartup.EndPhase(texturesPhase);
 
 	// Activate the program that will reference the texture
-	glUseProgram(gProgramId1);
+	glUseProgram(gSurfaceProgram.id);
 	// We set the texture as texture unit 0
-	glUniform1i(glGetUniformLocation(gProgramId1, "uTextureBase"), 0);
+	SetUniform(gSurfaceUniforms.texture, 0);
+
+	// Describe the scene now that its meshes and textures exist
+	size_t scenePhase = gStartup.BeginPhase("BuildScene");
+	BuildScene();
+	gStartup.EndPhase(scenePhase);
 
 	// Sets the background color of the window to black (it will be implicitely used by glClear)
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
 
-	// Render loop
-	while (!glfwWindowShouldClose(gWindow))
+	// Startup ends with the first frame Render() presents
+	gStartup.BeginPhase("FirstFrame");
+
+	// Render loop; the benchmark drives its own frames instead
+	if (gStressBenchmark)
+		RunStressBenchmark();
+
+	unsigned long long frameIndex = 0;
+	// A headless replay runs for as long as its log
+	while (!gStressBenchmark && (gHeadless ? gInputLog.IsReplaying() || frameIndex < gHeadlessFrames : !glfwWindowShouldClose(gWindow)))
 	{
+		PROFILE_FRAME();
+		PROFILE_ZONE("Frame");
+
 		// per-frame timing
 
-		float currentFrame = glfwGetTime();
+		float currentFrame = gHeadless ? frameIndex * HEADLESS_FRAME_TIME : (float)glfwGetTime();
 		gDeltaTime = currentFrame - gLastFrame;
 		gLastFrame = currentFrame;
+		++frameIndex;
+
+		// A replayed frame runs with its recorded time step; the replay ends with the log
+		if (!BeginInputFrame())
+			break;
 
 		// Process keyboard input before rendering
-		ProcessInput(gWindow);
+		if (!gHeadless || gInputLog.IsReplaying())
+			ProcessInput(gWindow);
 
 		// Render this frame
 		Render();
 
-		glfwPollEvents();
+		if (!gHeadless)
+		{
+			PROFILE_ZONE("PollEvents");
+			glfwPollEvents();
+		}
+		EndInputFrame();
+
+		// Hold the frame rate and record the frame time
+		{
+			PROFILE_ZONE("FramePacing");
+			gFramePacer.EndFrame();
+		}
+		if (currentFrame - gLastFrameReport >= FRAME_REPORT_INTERVAL)
+		{
+			ReportFrameTimes();
+			gLastFrameReport = currentFrame;
+		}
+	}
+
+	ReportFrameTimes();
+	PROFILE_FINISH_CAPTURE();
+
+	// The run ended before every texture was in; report the ones that are
+	if (gStartup.IsComplete() && !gStartupAssetsReported)
+		ReportStartupAssets();
+
+	if (gInputLog.IsRecording())
+		cout << "INFO: " << gInputLog.FrameCount() << " frames of input recorded to " << gRecordInputPath << endl;
+	gInputLog.Close();
+
+	if (gHeadless)
+	{
+		if (gHeadlessOutputPath && gOffscreenTarget.WritePpm(gHeadlessOutputPath))
+			cout << "INFO: Last frame written to " << gHeadlessOutputPath << endl;
+		gOffscreenTarget.Destroy();
+	}
+
+	if (gGpuProfiler.IsCreated())
+	{
+		if (gGpuProfilePath && gGpuProfiler.ExportCsv(gGpuProfilePath))
+			cout << "INFO: GPU timings written to " << gGpuProfilePath << endl;
+		gGpuProfiler.Destroy();
 	}
 
 	// Release mesh data
 	meshes.DestroyMeshes();
 	// Release shader program
-	DestroyShaderProgram(gProgramId1);
-	DestroyShaderProgram(gLampProgramId);
-	// Release the textures
-	DestroyTexture(gTextureIdBlue);
-	DestroyTexture(gTextureIdRed);
-	DestroyTexture(gTextureIdBrown);
-	DestroyTexture(gTextureIdGreen);
-
-	exit(EXIT_SUCCESS); // Terminates the program successfully
+	DestroyShaderProgram(gSurfaceProgram);
+	if (gHud.IsCreated())
+	{
+		gHud.Destroy();
+		DestroyShaderProgram(gHudProgram);
+	}
+	DestroyUniformBuffers();
+	gTransforms.Destroy();
+	gFrameRing.Destroy();
+	// Release the textures, and whatever was still streaming
+	gTextureStreamer.Destroy();
+	for (TextureArray& array : gTextureArrays)
+		DestroyTexture(array.id);
+	DestroyTexture(gPlaceholderArray);
+
+	gWorkers.Destroy();
+
+	// Everything is released by now: whatever the registry still holds has leaked
+	GpuMemory::Report();
+	bool overBudget = GpuMemory::OverBudget();
+	if (overBudget)
+		cout << "ERROR::GPU_MEMORY::OVER_BUDGET peak " << GpuMemory::Total().peakBytes << " bytes, budget " << gVramBudget << " bytes" << endl;
+
+	if (gHeadless)
+		DestroyHeadlessContext();
+
+	exit(overBudget || gStartupOverBudget ? EXIT_FAILURE : EXIT_SUCCESS); // Terminates the program successfully
+}
+
+// Read the options: --pacing uncapped|vsync|fixed, --fps N, --gpu-profile file.csv, //
+// --cpu-trace file.json, --trace-frames first count,                                //
+// --headless, --frames N, --output file.ppm,                                        //
+// --stress, --stress-tiers 10,100,..., --stress-frames N, --gl-stats,                //
+// --record-input file, --replay-input file, --vram-budget MB,                      //
+// --startup-report file.json, --startup-budget ms, --hud, --worker-threads N,      //
+// --no-texture-cache                                                               //
+bool ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--pacing") == 0 && i + 1 < argc)
+		{
+			if (!FramePacer::ParseMode(argv[++i], gPacingMode))
+			{
+				cout << "Unknown pacing mode " << argv[i] << " (expected uncapped, vsync or fixed)" << endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+		{
+			gTargetFps = atof(argv[++i]);
+			if (gTargetFps <= 0.0)
+			{
+				cout << "Invalid target frame rate " << argv[i] << endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--gpu-profile") == 0 && i + 1 < argc)
+		{
+			gGpuProfilePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--cpu-trace") == 0 && i + 1 < argc)
+		{
+			gCpuTracePath = argv[++i];
+#if !CPU_PROFILER_ENABLED
+			cout << "WARNING: built without the CPU profiler, --cpu-trace is ignored" << endl;
+#endif
+		}
+		else if (strcmp(argv[i], "--worker-threads") == 0 && i + 1 < argc)
+		{
+			int threads = atoi(argv[++i]);
+			if (threads < 0)
+			{
+				cout << "Invalid worker thread count " << argv[i] << endl;
+				return false;
+			}
+			gWorkerThreads = (unsigned int)threads;
+		}
+		else if (strcmp(argv[i], "--no-texture-cache") == 0)
+		{
+			gTextureCacheEnabled = false;
+		}
+		else if (strcmp(argv[i], "--hud") == 0)
+		{
+			gHudEnabled = true;
+		}
+		else if (strcmp(argv[i], "--gl-stats") == 0)
+		{
+			gGlStats = true;
+		}
+		else if (strcmp(argv[i], "--headless") == 0)
+		{
+			gHeadless = true;
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			gHeadlessFrames = strtoull(argv[++i], NULL, 10);
+			if (gHeadlessFrames == 0)
+			{
+				cout << "Invalid frame count " << argv[i] << endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			gHeadlessOutputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--stress") == 0)
+		{
+			gStressBenchmark = true;
+		}
+		else if (strcmp(argv[i], "--stress-tiers") == 0 && i + 1 < argc)
+		{
+			gStressBenchmark = true;
+			if (!ParseStressTiers(argv[++i]))
+			{
+				cout << "Invalid stress tiers " << argv[i] << " (expected a list like 10,100,1000)" << endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--stress-frames") == 0 && i + 1 < argc)
+		{
+			gStressFrames = atoi(argv[++i]);
+			if (gStressFrames <= 0)
+			{
+				cout << "Invalid stress frame count " << argv[i] << endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--record-input") == 0 && i + 1 < argc)
+		{
+			gRecordInputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay-input") == 0 && i + 1 < argc)
+		{
+			gReplayInputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--vram-budget") == 0 && i + 1 < argc)
+		{
+			double megabytes = atof(argv[++i]);
+			if (megabytes <= 0.0)
+			{
+				cout << "Invalid video memory budget " << argv[i] << endl;
+				return false;
+			}
+			gVramBudget = (size_t)(megabytes * 1024.0 * 1024.0);
+		}
+		else if (strcmp(argv[i], "--startup-report") == 0 && i + 1 < argc)
+		{
+			gStartupReportPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--startup-budget") == 0 && i + 1 < argc)
+		{
+			gStartupBudgetMs = atof(argv[++i]);
+			if (gStartupBudgetMs <= 0.0)
+			{
+				cout << "Invalid startup budget " << argv[i] << endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--trace-frames") == 0 && i + 2 < argc)
+		{
+			gCpuTraceFirstFrame = strtoull(argv[++i], NULL, 10);
+			gCpuTraceFrameCount = strtoull(argv[++i], NULL, 10);
+			if (gCpuTraceFrameCount == 0)
+			{
+				cout << "Invalid trace frame count " << argv[i] << endl;
+				return false;
+			}
+		}
+		else
+		{
+			cout << "Unknown argument " << argv[i] << endl;
+			return false;
+		}
+	}
+
+	if (gRecordInputPath && gReplayInputPath)
+	{
+		cout << "--record-input and --replay-input cannot be combined" << endl;
+		return false;
+	}
+
+	// There is no display to synchronize with, and benchmarks must not be capped by one
+	if ((gHeadless || gStressBenchmark) && gPacingMode == FramePacer::PACING_VSYNC)
+		gPacingMode = FramePacer::PACING_UNCAPPED;
+
+	return true;
+}
+
+// Print the frame-time percentiles of the recent frames //
+void ReportFrameTimes()
+{
+	FramePacer::Percentiles report = gFramePacer.Report();
+	if (report.samples == 0)
+		return;
+
+	cout << "INFO: Frame time (" << FramePacer::ModeName(gFramePacer.GetMode());
+	if (gFramePacer.GetMode() == FramePacer::PACING_FIXED)
+		cout << " " << gFramePacer.TargetFps() << " fps";
+	cout << ", " << report.samples << " frames): p50 " << report.p50 << " ms, p95 " << report.p95
+		<< " ms, p99 " << report.p99 << " ms, max " << report.max << " ms" << endl;
+
+	if (GlTrace::IsInstalled())
+	{
+		const GlTrace::Counters& counters = GlTrace::LastFrame();
+		cout << "INFO: GL calls per frame: " << counters.calls << " (" << counters.drawCalls << " draws, "
+			<< counters.uniformUploads << " uniform uploads, " << counters.binds << " binds of which "
+			<< counters.redundantBinds << " redundant), " << counters.bytesUploaded << " bytes uploaded, "
+			<< counters.bytesCopied << " bytes copied, " << gLastStreamedBytes << " bytes streamed" << endl;
+	}
+
+	GpuMemory::Stats memory = GpuMemory::Total();
+	cout << "INFO: GPU memory: " << memory.liveBytes / (1024.0 * 1024.0) << " MB live in " << memory.liveCount
+		<< " resources, peak " << memory.peakBytes / (1024.0 * 1024.0) << " MB" << endl;
+
+	for (const GpuProfiler::ScopeStats& scope : gGpuProfiler.Scopes())
+	{
+		if (scope.samples > 0)
+			cout << "INFO: GPU " << scope.name << ": avg " << scope.average << " ms, max " << scope.max << " ms" << endl;
+	}
 }
 
 // Initialize GLFW, GLEW, and create a window //
 bool Initialize(int argc, char* argv[], GLFWwindow** window)
+{
+	{
+		StartupPhase phase(gStartup, "CreateContext");
+		if (gHeadless)
+		{
+			if (!CreateHeadlessContext())
+				return false;
+			cout << "INFO: Headless context (" << HeadlessBackendName() << ")" << endl;
+		}
+		else if (!InitializeWindow(window))
+			return false;
+	}
+
+	// GLEW: initialize
+	// ----------------
+	// Note: if using GLEW version 1.13 or earlier
+	glewExperimental = GL_TRUE;
+	GLenum GlewInitResult;
+	{
+		StartupPhase phase(gStartup, "glewInit");
+		GlewInitResult = glewInit();
+	}
+	// If init fails, output error string, return error
+	if (GLEW_OK != GlewInitResult)
+	{
+		std::cerr << glewGetErrorString(GlewInitResult) << std::endl;
+		return false;
+	}
+
+	// Displays GPU OpenGL version
+	cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << endl;
+
+	return true;
+}
+
+// Create the visible window, its context and the input callbacks //
+bool InitializeWindow(GLFWwindow** window)
 {
 	// GLFW: initialize and configure
 	glfwInit();
@@ -323,58 +985,118 @@ bool Initialize(int argc, char* argv[], GLFWwindow** window)
 	// tell GLFW to capture our mouse
 	glfwSetInputMode(*window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-	// GLEW: initialize
-	// ----------------
-	// Note: if using GLEW version 1.13 or earlier
-	glewExperimental = GL_TRUE;
-	GLenum GlewInitResult = glewInit();
-	// If init fails, output error string, return error
-	if (GLEW_OK != GlewInitResult)
-	{
-		std::cerr << glewGetErrorString(GlewInitResult) << std::endl;
-		return false;
-	}
-
-	// Displays GPU OpenGL version
-	cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << endl;
-
 	return true;
 }
 
 // Process keyboard input
 void ProcessInput(GLFWwindow* window)
 {
+	PROFILE_ZONE("ProcessInput");
+
 	static const float cameraSpeed = 2.5f;
 
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	if (IsKeyPressed(window, GLFW_KEY_ESCAPE) && window)
 		glfwSetWindowShouldClose(window, true);
 
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+	if (IsKeyPressed(window, GLFW_KEY_W))
 		gCamera.ProcessKeyboard(FORWARD, gDeltaTime);
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+	if (IsKeyPressed(window, GLFW_KEY_S))
 		gCamera.ProcessKeyboard(BACKWARD, gDeltaTime);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+	if (IsKeyPressed(window, GLFW_KEY_A))
 		gCamera.ProcessKeyboard(LEFT, gDeltaTime);
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+	if (IsKeyPressed(window, GLFW_KEY_D))
 		gCamera.ProcessKeyboard(RIGHT, gDeltaTime);
 
 	// Add stubs for Q/E Upward/Downward movement
-	if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
+	if (IsKeyPressed(window, GLFW_KEY_Q))
 		gCamera.ProcessKeyboard(UP, gDeltaTime);
-	if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
+	if (IsKeyPressed(window, GLFW_KEY_E))
 		gCamera.ProcessKeyboard(DOWN, gDeltaTime);
+}
+
+// Polled key state: read from the replayed log, or from the window and recorded //
+bool IsKeyPressed(GLFWwindow* window, int key)
+{
+	const unsigned int keyCount = sizeof(RECORDED_KEYS) / sizeof(RECORDED_KEYS[0]);
+	unsigned int bit = 0;
+	while (bit < keyCount && RECORDED_KEYS[bit] != key)
+		++bit;
 
-	// Add stubs to change view
-	if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS)
+	if (gInputLog.IsReplaying())
+		return bit < keyCount && (gInputFrame.keys >> bit) & 1u;
+
+	bool pressed = glfwGetKey(window, key) == GLFW_PRESS;
+	if (pressed && bit < keyCount && gInputLog.IsRecording())
+		gInputFrame.keys |= 1u << bit;
+
+	return pressed;
+}
+
+// Start a frame of input: take the next replayed frame and its time step, //
+// or clear the frame being recorded. False once the replayed log ends     //
+bool BeginInputFrame()
+{
+	if (gInputLog.IsReplaying())
 	{
-		// Reset the flag
-		if (perspectiveMode)
-			perspectiveMode = false;
-		else
-			perspectiveMode = true;
+		if (!gInputLog.ReadFrame(gInputFrame))
+		{
+			cout << "INFO: Input replay finished after " << gInputLog.FrameCount() << " frames" << endl;
+			return false;
+		}
+		gDeltaTime = gInputFrame.deltaTime;
+	}
+	else if (gInputLog.IsRecording())
+	{
+		gInputFrame.deltaTime = gDeltaTime;
+		gInputFrame.keys = 0;
+		gInputFrame.events.clear();
+	}
+
+	return true;
+}
+
+// End a frame of input: write the recorded frame, or run the replayed  //
+// events through the callbacks at the point the live ones were polled //
+void EndInputFrame()
+{
+	if (gInputLog.IsRecording())
+	{
+		gInputLog.WriteFrame(gInputFrame);
+	}
+	else if (gInputLog.IsReplaying())
+	{
+		gDispatchingReplay = true;
+		for (const InputLog::Event& event : gInputFrame.events)
+		{
+			switch (event.type)
+			{
+			case InputLog::EVENT_CURSOR:
+				UMousePositionCallback(gWindow, event.x, event.y);
+				break;
+			case InputLog::EVENT_SCROLL:
+				UMouseScrollCallback(gWindow, event.x, event.y);
+				break;
+			case InputLog::EVENT_MOUSE_BUTTON:
+				UMouseButtonCallback(gWindow, (int)event.x, (int)event.y, 0);
+				break;
+			}
+		}
+		gDispatchingReplay = false;
 	}
 }
 
+// Live window events are recorded, or dropped while a log is replayed //
+bool AcceptInputEvent(uint8_t type, double x, double y)
+{
+	if (gInputLog.IsReplaying())
+		return gDispatchingReplay;
+
+	if (gInputLog.IsRecording())
+		gInputFrame.events.push_back({ type, x, y });
+
+	return true;
+}
+
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 void UResizeWindow(GLFWwindow* window, int width, int height)
 {
@@ -385,6 +1107,9 @@ void UResizeWindow(GLFWwindow* window, int width, int height)
 // -------------------------------------------------------
 void UMousePositionCallback(GLFWwindow* window, double xpos, double ypos)
 {
+	if (!AcceptInputEvent(InputLog::EVENT_CURSOR, xpos, ypos))
+		return;
+
 	if (gFirstMouse)
 	{
 		gLastX = xpos;
@@ -405,6 +1130,9 @@ void UMousePositionCallback(GLFWwindow* window, double xpos, double ypos)
 // ----------------------------------------------------------------------
 void UMouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 {
+	if (!AcceptInputEvent(InputLog::EVENT_SCROLL, xoffset, yoffset))
+		return;
+
 	gCamera.ProcessMouseScroll(yoffset);
 }
 
@@ -412,6 +1140,9 @@ void UMouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 // --------------------------------
 void UMouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
+	if (!AcceptInputEvent(InputLog::EVENT_MOUSE_BUTTON, button, action))
+		return;
+
 	switch (button)
 	{
 	case GLFW_MOUSE_BUTTON_LEFT:
@@ -447,667 +1178,417 @@ void UMouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 	}
 }
 
-// Function called to render a frame
-// --------------------------------
-void SwitchPerspective()
-{
-	// Return the correct perspective
-	if (perspectiveMode)
-	{
-		// Perspective
-		_Projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
-	}
-	else
-	{
-		// Org
-		_Projection = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 100.0f);
-	}
-}
-
 // Render the next frame to the OpenGL viewport //
 void Render()
 {
-	GLuint uHasTextureLoc;
-	bool ubHasTextureVal;
-	glm::mat4 scale;
-	glm::mat4 rotation;
-	glm::mat4 translation;
-	glm::mat4 model;
-	GLint modelLoc;
-	GLint viewLoc;
-	GLint projLoc;
-	GLint viewPosLoc;
-	GLint ambStrLoc;
-	GLint ambColLoc;
-	GLint light1ColLoc;
-	GLint light1PosLoc;
-	GLint light2ColLoc;
-	GLint light2PosLoc;
-	GLint objColLoc;
-	GLint specInt1Loc;
-	GLint highlghtSz1Loc;
-	GLint specInt2Loc;
-	GLint highlghtSz2Loc;
+	PROFILE_ZONE("Render");
+	std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
 
 	// Enable z-depth
 	glEnable(GL_DEPTH_TEST);
 
+	// Wait for the GPU to release this frame's section of the ring
+	{
+		PROFILE_ZONE("RingWait");
+		gFrameRing.BeginFrame();
+	}
+
+	// Swap in textures whose upload finished and start the next ones, without waiting on the GPU
+	StreamDecodedTextures();
+	gGpuProfiler.BeginFrame();
+	gGpuProfiler.BeginScope("FRAME");
+
 	// Clear the background
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	
+	{
+		GpuScope scope(gGpuProfiler, "CLEAR");
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
 
 	// camera/view transformation
 	glm::mat4 view = gCamera.GetViewMatrix();
 
 	// Creates a perspective projection
-	glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+	glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, gFarPlane);
+
+	// Upload the camera and lights once for the whole frame
+	UpdateFrameUniforms(view, projection);
+
+	// Refresh only the matrices that changed and send them to the GPU
+	{
+		PROFILE_ZONE("Transforms");
+		gTransforms.Update(projection * view);
+		gTransforms.Upload(gFrameRing);
+	}
+
+	// Queue every scene object, then let the queue order the draws by GPU state
+	std::chrono::steady_clock::time_point submitStart = std::chrono::steady_clock::now();
+	{
+		PROFILE_ZONE("Submit");
+		gRenderQueue.Clear();
+		for (const SceneObject& object : gScene)
+			SubmitSceneObject(object, view);
+	}
+
+	{
+		PROFILE_ZONE("Sort");
+		gRenderQueue.Sort();
+	}
+
+	{
+		PROFILE_ZONE("Execute");
+		GpuScope scope(gGpuProfiler, "SCENE");
+		if (gGpuProfiler.IsCreated() && gRenderQueue.Grouping())
+		{
+			// With grouping on, each group is one scene section
+			gRenderQueue.Execute(gFrameRing,
+				[](uint8_t section) { gGpuProfiler.BeginScope(gSectionNames[section]); },
+				[](uint8_t) { gGpuProfiler.EndScope(); });
+		}
+		else
+			gRenderQueue.Execute(gFrameRing);
+	}
+	gLastSubmitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
 
-	// Set the program to be used
-	glUseProgram(gProgramId1);
+	// The overlay shows the last frames the profiler has results for, and is itself timed
+	if (gHud.IsCreated())
+	{
+		const GpuProfiler::ScopeStats* gpuFrame = gGpuProfiler.Find("FRAME");
+		const GpuProfiler::ScopeStats* gpuHud = gGpuProfiler.Find("HUD");
+
+		PerfHud::FrameStats stats;
+		stats.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+		stats.gpuMs = gpuFrame && gpuFrame->samples > 0 ? gpuFrame->last : -1.0;
+		stats.hudGpuMs = gpuHud && gpuHud->samples > 0 ? gpuHud->last : -1.0;
+		stats.drawCalls = gRenderQueue.LastStats().draws;
+		stats.objects = gRenderQueue.LastStats().instances;
+		stats.textureBytes = GpuMemory::Query(GpuMemory::CATEGORY_TEXTURE).liveBytes;
+		stats.bufferBytes = GpuMemory::Query(GpuMemory::CATEGORY_BUFFER).liveBytes;
+		gHud.AddFrame(stats);
+
+		GpuScope scope(gGpuProfiler, "HUD");
+		gHud.Draw(gFrameRing, WINDOW_WIDTH, WINDOW_HEIGHT);
+	}
 
-	// Get the has texture location
-	uHasTextureLoc = glGetUniformLocation(gProgramId1, "ubHasTexture");
+	gGpuProfiler.EndScope();
+	gGpuProfiler.EndFrame();
 
+	// Everything this frame wrote to the ring is read by now-submitted commands
+	gLastStreamedBytes = gFrameRing.BytesUsed();
+	gFrameRing.EndFrame();
 
-	ubHasTextureVal = false;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
+	// Flips the the back buffer with the front buffer every frame (refresh);
+	// headless frames stay in the offscreen target
+	PROFILE_ZONE("SwapBuffers");
+	if (gHeadless)
+		glFlush();
+	else
+		glfwSwapBuffers(gWindow);
+
+	if (!gStartup.IsComplete())
+		FinishStartup();
+
+	GlTrace::EndFrame();
+}
+
+// The first frame is out: close the startup timeline and report it //
+void FinishStartup()
+{
+	// Wait for the GPU so the endpoint is the frame being done, not just queued
+	glFinish();
+	gStartup.MarkFirstFrame();
+	gStartup.Print();
+
+	if (gStartup.AssetsSettled())
+		ReportStartupAssets();
+
+	if (gStartupBudgetMs > 0.0 && gStartup.TimeToFirstFrameMs() > gStartupBudgetMs)
+	{
+		cout << "ERROR::STARTUP::OVER_BUDGET " << gStartup.TimeToFirstFrameMs() << " ms to the first frame, budget "
+			<< gStartupBudgetMs << " ms" << endl;
+		gStartupOverBudget = true;
+	}
+}
+
+// Every texture is in, or startup ended before they were: report when each loaded and swapped in //
+void ReportStartupAssets()
+{
+	gStartupAssetsReported = true;
+	gStartup.PrintAssets();
+
+	if (gStartupReportPath && gStartup.WriteJson(gStartupReportPath, gStartupBudgetMs))
+		cout << "INFO: Startup report written to " << gStartupReportPath << endl;
+}
+
+// Queue the parts of one scene object //
+void SubmitSceneObject(const SceneObject& object, const glm::mat4& view)
+{
+	// Distance along the view direction, used to draw front to back
+	float viewDepth = -(view * glm::vec4(gTransforms.Position(object.transform), 1.0f)).z;
+
+	for (const Meshes::SubMesh& part : object.parts)
+		gRenderQueue.Submit(gSurfaceProgram.id, *object.mesh, part, object.material, gTextureSlots[MATERIAL_TEXTURES[object.material]].array,
+			object.transform, viewDepth, object.sectionId);
+}
+
+// Add one object to the static scene //
+void AddSceneObject(const char* section, const Meshes::GLMesh& mesh, std::initializer_list<Meshes::SubMesh> parts,
+	MaterialId material, glm::vec3 scale, float rotationAngle, glm::vec3 rotationAxis, glm::vec3 translation)
+{
+	// Sections are told apart by name; objects of one section share an id
+	size_t sectionId = 0;
+	while (sectionId < gSectionNames.size() && strcmp(gSectionNames[sectionId], section) != 0)
+		++sectionId;
+	if (sectionId == gSectionNames.size())
+		gSectionNames.push_back(section);
+
+	SceneObject object;
+	object.section = section;
+	object.sectionId = (uint8_t)sectionId;
+	object.mesh = &mesh;
+	object.parts = parts;
+	object.material = material;
+	object.transform = gTransforms.Add(translation, rotationAngle, rotationAxis, scale);
+	object.scale = scale;
+	object.rotationAngle = rotationAngle;
+	object.rotationAxis = rotationAxis;
+	object.translation = translation;
+
+	gScene.push_back(object);
+}
 
-	// Retrieves and passes transform matrices to the Shader program
-	modelLoc = glGetUniformLocation(gProgramId1, "model");
-	viewLoc = glGetUniformLocation(gProgramId1, "view");
-	projLoc = glGetUniformLocation(gProgramId1, "projection");
-	glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-	glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+// Describe the static scene once; Render() submits it to the render queue every frame //
+void BuildScene()
+{
+	const Meshes::SubMesh& cylinderBottom = meshes.gCylinderMesh.parts[Meshes::CYLINDER_BOTTOM];
+	const Meshes::SubMesh& cylinderTop = meshes.gCylinderMesh.parts[Meshes::CYLINDER_TOP];
+	const Meshes::SubMesh& cylinderSides = meshes.gCylinderMesh.parts[Meshes::CYLINDER_SIDES];
+	const Meshes::SubMesh& coneBottom = meshes.gConeMesh.parts[Meshes::CONE_BOTTOM];
+	const Meshes::SubMesh& coneSides = meshes.gConeMesh.parts[Meshes::CONE_SIDES];
+	const Meshes::SubMesh& sphere = meshes.gSphereMesh.parts[0];
+	const Meshes::SubMesh& plane = meshes.gPlaneMesh.parts[0];
 
-	viewPosLoc = glGetUniformLocation(gProgramId1, "viewPosition");
-	ambStrLoc = glGetUniformLocation(gProgramId1, "ambientStrength");
-	ambColLoc = glGetUniformLocation(gProgramId1, "ambientColor");
-	light1ColLoc = glGetUniformLocation(gProgramId1, "light1Color");
-	light1PosLoc = glGetUniformLocation(gProgramId1, "light1Position");
-	light2ColLoc = glGetUniformLocation(gProgramId1, "light2Color");
-	light2PosLoc = glGetUniformLocation(gProgramId1, "light2Position");
-	objColLoc = glGetUniformLocation(gProgramId1, "objectColor");
-	specInt1Loc = glGetUniformLocation(gProgramId1, "specularIntensity1");
-	highlghtSz1Loc = glGetUniformLocation(gProgramId1, "highlightSize1");
-	specInt2Loc = glGetUniformLocation(gProgramId1, "specularIntensity2");
-	highlghtSz2Loc = glGetUniformLocation(gProgramId1, "highlightSize2");
-	uHasTextureLoc = glGetUniformLocation(gProgramId1, "ubHasTexture");
+	// The first 720 sphere indices cover its upper half
+	const Meshes::SubMesh hemisphere = { GL_TRIANGLES, 0, 720, true };
 
+	gScene.clear();
+	gSectionNames.clear();
 
 	//////BOWL PARTS/////
 
 	// Bottom of bowl
-	glBindVertexArray(meshes.gCylinderMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(0.3f, 0.06f, 0.3f));
-	rotation = glm::rotate(0.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-	translation = glm::translate(glm::vec3(0.0f, 0.0f, 0.5f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 0.0f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	//glUniform3f(light2ColLoc, 0.8f, 1.0f, 0.8f);
-	//glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdWhite);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawElements(GL_TRIANGLES, 720, GL_UNSIGNED_INT, (void*)0);
-
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	//	glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-	//	glDrawArrays(GL_TRIANGLE_FAN, 36, 72);		//top
-	glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
-
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	AddSceneObject("BOWL PARTS", meshes.gCylinderMesh, { cylinderSides }, MATERIAL_BOWL_BASE,
+		glm::vec3(0.3f, 0.06f, 0.3f), 0.0f, glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.5f));
 
 	// Bowl
-	glBindVertexArray(meshes.gSphereMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(1.0f, 0.4f, 1.0f));
-	rotation = glm::rotate(3.142f, glm::vec3(1.0f, 0.0f, 0.0f));
-	translation = glm::translate(glm::vec3(0.0f, 0.42f, 0.5f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 0.5f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	//glUniform3f(light2ColLoc, 0.0f, 0.0f, 0.0f);
-	//glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdWhite);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawElements(GL_TRIANGLES, 720, GL_UNSIGNED_INT, (void*)0);
-
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
-
+	AddSceneObject("BOWL PARTS", meshes.gSphereMesh, { hemisphere }, MATERIAL_BOWL,
+		glm::vec3(1.0f, 0.4f, 1.0f), 3.142f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.42f, 0.5f));
 
 	/////WINE BOTTLE PARTS/////
 
 	// Cork
-	glBindVertexArray(meshes.gCylinderMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(0.09f, 0.25f, 0.09f));
-	rotation = glm::rotate(0.00f, glm::vec3(1.0f, 0.0f, 0.0f));
-	translation = glm::translate(glm::vec3(2.0f, 1.9f, -1.0f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 1.0f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	glUniform3f(light2ColLoc, 0.8f, 1.0f, 0.8f);
-	glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdBrown);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-	glDrawArrays(GL_TRIANGLE_FAN, 36, 72);		//top
-	glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
-
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	AddSceneObject("WINE BOTTLE PARTS", meshes.gCylinderMesh, { cylinderBottom, cylinderTop, cylinderSides }, MATERIAL_CORK,
+		glm::vec3(0.09f, 0.25f, 0.09f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(2.0f, 1.9f, -1.0f));
 
 	// Bottle neck top
-	glBindVertexArray(meshes.gCylinderMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(0.12f, 0.5f, 0.12f));
-	rotation = glm::rotate(0.00f, glm::vec3(1.0f, 0.0f, 0.0f));
-	translation = glm::translate(glm::vec3(2.0f, 1.5f, -1.0f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 0.5f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	glUniform3f(light2ColLoc, 0.8f, 1.0f, 0.8f);
-	glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-	
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdYellow);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-	glDrawArrays(GL_TRIANGLE_FAN, 36, 72);		//top
-	glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
-
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	AddSceneObject("WINE BOTTLE PARTS", meshes.gCylinderMesh, { cylinderBottom, cylinderTop, cylinderSides }, MATERIAL_BOTTLE_NECK,
+		glm::vec3(0.12f, 0.5f, 0.12f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(2.0f, 1.5f, -1.0f));
 
 	// Bottle neck bottom
-	glBindVertexArray(meshes.gConeMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(0.4f, 0.5f, 0.4f));
-	rotation = glm::rotate(0.00f, glm::vec3(1.0f, -1.0f, 0.0f));
-	translation = glm::translate(glm::vec3(2.0f, 1.25f, -1.0f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 0.5f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	glUniform3f(light2ColLoc, 0.8f, 1.0f, 0.8f);
-	glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-	
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdYellow);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-	glDrawArrays(GL_TRIANGLE_STRIP, 36, 108);	//sides
-
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	AddSceneObject("WINE BOTTLE PARTS", meshes.gConeMesh, { coneBottom, coneSides }, MATERIAL_BOTTLE_NECK,
+		glm::vec3(0.4f, 0.5f, 0.4f), 0.0f, glm::vec3(1.0f, -1.0f, 0.0f), glm::vec3(2.0f, 1.25f, -1.0f));
 
 	// Bottle
-	glBindVertexArray(meshes.gCylinderMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(0.40f, 1.25f, 0.40f));
-	rotation = glm::rotate(3.142f, glm::vec3(1.0f, 0.0f, 0.0f));
-	translation = glm::translate(glm::vec3(2.0f, 1.25f, -1.0f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 0.0f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	//glUniform3f(light2ColLoc, 0.8f, 1.0f, 0.8f);
-	//glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdGreen);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-    glDrawArrays(GL_TRIANGLE_FAN, 36, 72);		//top
-	glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
-
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	AddSceneObject("WINE BOTTLE PARTS", meshes.gCylinderMesh, { cylinderBottom, cylinderTop, cylinderSides }, MATERIAL_BOTTLE,
+		glm::vec3(0.40f, 1.25f, 0.40f), 3.142f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(2.0f, 1.25f, -1.0f));
 
 	//////TABLE//////
 
 	// Table
-	glBindVertexArray(meshes.gPlaneMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(3.0f, 3.0f, 3.0f));
-	rotation = glm::rotate(0.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-	translation = glm::translate(glm::vec3(0.25f, -0.01f, -1.0f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 0.0f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	glUniform3f(light2ColLoc, 1.0f, 1.0f, 1.0f);
-	glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, 1.0f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdRed);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawElements(GL_TRIANGLES, meshes.gPlaneMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
-
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
-
+	AddSceneObject("TABLE", meshes.gPlaneMesh, { plane }, MATERIAL_TABLE,
+		glm::vec3(3.0f, 3.0f, 3.0f), 0.0f, glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(0.25f, -0.01f, -1.0f));
 
 	//////ICE CREAM//////
 
 	// Ice Cream scoop#1
-	glBindVertexArray(meshes.gSphereMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(-0.45f, -0.25f, -0.45f));
-	rotation = glm::rotate(0.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-	translation = glm::translate(glm::vec3(-0.35f, 0.35f, 0.55f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 1.0f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	//glUniform3f(light2ColLoc, 0.8f, 1.0f, 0.8f);
-	//glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdBlue);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawElements(GL_TRIANGLES, meshes.gSphereMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
-
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	AddSceneObject("ICE CREAM", meshes.gSphereMesh, { sphere }, MATERIAL_ICE_CREAM,
+		glm::vec3(-0.45f, -0.25f, -0.45f), 0.0f, glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(-0.35f, 0.35f, 0.55f));
 
 	// Ice Cream scoop#2
-	glBindVertexArray(meshes.gSphereMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(-0.45f, -0.25f, -0.45f));
-	rotation = glm::rotate(0.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-	translation = glm::translate(glm::vec3(0.25f, 0.35f, 0.75f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 1.0f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	//glUniform3f(light2ColLoc, 0.8f, 1.0f, 0.8f);
-	//glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-	
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdBlue);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawElements(GL_TRIANGLES, meshes.gSphereMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
-
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	AddSceneObject("ICE CREAM", meshes.gSphereMesh, { sphere }, MATERIAL_ICE_CREAM,
+		glm::vec3(-0.45f, -0.25f, -0.45f), 0.0f, glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(0.25f, 0.35f, 0.75f));
 
 	// Ice Cream scoop#3
-	glBindVertexArray(meshes.gSphereMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(-0.45f, -0.25f, -0.45f));
-	rotation = glm::rotate(0.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-	translation = glm::translate(glm::vec3(0.13f, 0.35f, 0.2f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 1.0f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	//glUniform3f(light2ColLoc, 0.8f, 1.0f, 0.8f);
-	//glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdBlue);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawElements(GL_TRIANGLES, meshes.gSphereMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
-
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	AddSceneObject("ICE CREAM", meshes.gSphereMesh, { sphere }, MATERIAL_ICE_CREAM,
+		glm::vec3(-0.45f, -0.25f, -0.45f), 0.0f, glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(0.13f, 0.35f, 0.2f));
 
 	// Ice Cream scoop#4
-	glBindVertexArray(meshes.gSphereMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(-0.38f, -0.25f, -0.38f));
-	rotation = glm::rotate(0.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-	translation = glm::translate(glm::vec3(0.0f, 0.62f, 0.45f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 1.0f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	//glUniform3f(light2ColLoc, 0.8f, 1.0f, 0.8f);
-	//glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdBlue);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawElements(GL_TRIANGLES, meshes.gSphereMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	AddSceneObject("ICE CREAM", meshes.gSphereMesh, { sphere }, MATERIAL_ICE_CREAM,
+		glm::vec3(-0.38f, -0.25f, -0.38f), 0.0f, glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(0.0f, 0.62f, 0.45f));
 
 	//////SPOON/////
 
-//Spoon
-	glBindVertexArray(meshes.gSphereMesh.vao);
-
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(.18f, 0.1f, 0.25f));
-	rotation = glm::rotate(3.142f, glm::vec3(1.0f, 0.0f, 0.0f));
-	translation = glm::translate(glm::vec3(-1.5f, 0.090f, -0.5f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 2.0f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	//glUniform3f(light2ColLoc, 0.8f, 1.0f, 0.8f);
-	//glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
-
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdSilver);
-
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
-
-	glDrawElements(GL_TRIANGLES, 720, GL_UNSIGNED_INT, (void*)0);
-
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	// Spoon
+	AddSceneObject("SPOON", meshes.gSphereMesh, { hemisphere }, MATERIAL_SPOON,
+		glm::vec3(0.18f, 0.1f, 0.25f), 3.142f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.5f, 0.090f, -0.5f));
 
 	// Spoon Handle
-	glBindVertexArray(meshes.gCylinderMesh.vao);
+	AddSceneObject("SPOON", meshes.gCylinderMesh, { cylinderTop, cylinderSides }, MATERIAL_SPOON_HANDLE,
+		glm::vec3(0.040f, 0.88f, 0.015f), 1.60f, glm::vec3(10.0f, -0.0f, 0.20f), glm::vec3(-1.5f, 0.05f, -0.27f));
 
-	// Set the mesh transfomation values
-	scale = glm::scale(glm::vec3(0.040f, 0.88f, 0.015f));
-	rotation = glm::rotate(1.60f, glm::vec3(10.0f, -0.0f, 0.20f));
-	translation = glm::translate(glm::vec3(-1.5f, 0.05f, -0.27f));
-	model = translation * rotation * scale;
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+	gTableSet = gScene;
+}
 
-	//set the camera view location
-	glUniform3f(viewPosLoc, gCamera.Position.x, gCamera.Position.y, gCamera.Position.z);
-	//set ambient lighting strength
-	glUniform1f(ambStrLoc, 0.5f);
-	//set ambient color
-	glUniform3f(ambColLoc, 0.1f, 0.1f, 0.1f);
-	glUniform3f(light1ColLoc, 1.0f, 0.8f, 0.8f);
-	glUniform3f(light1PosLoc, -0.5f, 1.0f, -1.0f);
-	//glUniform3f(light2ColLoc, 0.8f, 1.0f, 0.8f);
-	//glUniform3f(light2PosLoc, 0.5f, 1.0f, -1.0f);
-	//set specular intensity
-	glUniform1f(specInt1Loc, .4f);
-	glUniform1f(specInt2Loc, .4f);
-	//set specular highlight size
-	glUniform1f(highlghtSz1Loc, 2.0f);
-	glUniform1f(highlghtSz2Loc, 32.0f);
+// Replace the scene with objectCount objects: copies of the table set laid out on a grid, //
+// each copy turned and scaled at random and every object given a random material, which   //
+// brings its texture along                                                                 //
+void BuildStressScene(size_t objectCount, std::mt19937& random)
+{
+	std::uniform_real_distribution<float> angle(0.0f, 6.2832f);
+	std::uniform_real_distribution<float> jitter(-0.25f, 0.25f);
+	std::uniform_real_distribution<float> setScale(0.8f, 1.2f);
+	std::uniform_int_distribution<int> material(0, MATERIAL_COUNT - 1);
+
+	const size_t setSize = gTableSet.size();
+	const size_t setCount = (objectCount + setSize - 1) / setSize;
+	const size_t columns = (size_t)std::ceil(std::sqrt((double)setCount));
+	const size_t rows = (setCount + columns - 1) / columns;
+
+	gScene.clear();
+	gTransforms.Clear();
+
+	glm::vec3 origin;
+	float yaw = 0.0f;
+	float scale = 1.0f;
+	for (size_t i = 0; i < objectCount; ++i)
+	{
+		// Start a new copy of the set
+		size_t set = i / setSize;
+		if (i % setSize == 0)
+		{
+			origin = glm::vec3(((float)(set % columns) - (columns - 1) * 0.5f) * STRESS_SET_SPACING + jitter(random), 0.0f,
+				((float)(set / columns) - (rows - 1) * 0.5f) * STRESS_SET_SPACING + jitter(random));
+			yaw = angle(random);
+			scale = setScale(random);
+		}
+
+		SceneObject object = gTableSet[i % setSize];
+		object.material = (MaterialId)material(random);
+
+		// Turn the object's offset within the set about the set's own Y axis
+		float cosYaw = std::cos(yaw), sinYaw = std::sin(yaw);
+		glm::vec3 offset = object.translation * scale;
+		object.translation = origin + glm::vec3(cosYaw * offset.x + sinYaw * offset.z, offset.y, -sinYaw * offset.x + cosYaw * offset.z);
+		object.scale *= scale;
 
+		object.transform = gTransforms.Add(object.translation, object.rotationAngle, object.rotationAxis, object.scale);
+		gTransforms.Rotate(object.transform, yaw, glm::vec3(0.0f, 1.0f, 0.0f));
 
-	ubHasTextureVal = true;
-	glUniform1i(uHasTextureLoc, ubHasTextureVal);
+		gScene.push_back(object);
+	}
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gTextureIdSilver);
+	// Look down on the whole grid from behind its near edge
+	float extent = std::max(columns, rows) * STRESS_SET_SPACING;
+	gCamera.Position = glm::vec3(0.0f, extent * 0.6f + 2.0f, extent * 0.7f + 4.0f);
+	gCamera.Yaw = -90.0f;
+	gCamera.Pitch = -40.0f;
+	gCamera.ProcessMouseMovement(0.0f, 0.0f);
 
-	glUniform2f(glGetUniformLocation(gProgramId1, "uvScale"), 1.0f, 1.0f);
+	gFarPlane = std::max(100.0f, extent * 2.5f);
+	gRenderQueue.depthRange = gFarPlane;
+}
 
-	//glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-	glDrawArrays(GL_TRIANGLE_FAN, 36, 72);		//top
-	glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
+// Render every tier of the stress scene and print what each one cost //
+void RunStressBenchmark()
+{
+	// The benchmark always needs the GPU time of the scene
+	if (!gGpuProfiler.IsCreated())
+		gGpuProfiler.Create();
 
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	std::mt19937 random(STRESS_SEED);
+
+	cout << "INFO: Stress benchmark, " << gStressFrames << " frames per tier" << endl;
+	cout << "objects, mdi_calls/frame, draws/frame, cpu_submit_ms, gpu_scene_ms, frame_ms, draws/s" << endl;
+
+	for (size_t objectCount : gStressTiers)
+	{
+		if (!gHeadless && glfwWindowShouldClose(gWindow))
+			break;
+
+		BuildStressScene(objectCount, random);
+
+		// Let the ring and the transform buffer grow to the new scene size first
+		for (int frame = 0; frame < STRESS_WARMUP_FRAMES; ++frame)
+		{
+			Render();
+			if (!gHeadless)
+				glfwPollEvents();
+		}
+
+		// GPU results lag a few frames, so the first samples still come from warm-up frames
+		gGpuProfiler.ResetStats();
+
+		double submitMs = 0.0;
+		unsigned long long mdiCalls = 0, draws = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < gStressFrames; ++frame)
+		{
+			Render();
+			if (!gHeadless)
+				glfwPollEvents();
+
+			submitMs += gLastSubmitMs;
+			mdiCalls += gRenderQueue.LastStats().draws;
+			draws += gRenderQueue.LastStats().instances;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const GpuProfiler::ScopeStats* gpuScene = gGpuProfiler.Find("SCENE");
+
+		// A draw is one mesh part of one object, however the queue batched it
+		cout << objectCount << ", "
+			<< (double)mdiCalls / gStressFrames << ", "
+			<< (double)draws / gStressFrames << ", "
+			<< submitMs / gStressFrames << ", "
+			<< (gpuScene ? gpuScene->average : 0.0) << ", "
+			<< seconds * 1000.0 / gStressFrames << ", "
+			<< draws / seconds << endl;
+	}
+}
 
+// Read a comma-separated list of object counts //
+bool ParseStressTiers(const char* list)
+{
+	gStressTiers.clear();
 
-	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	const char* cursor = list;
+	while (*cursor)
+	{
+		char* end = NULL;
+		unsigned long long count = strtoull(cursor, &end, 10);
+		if (end == cursor || count == 0)
+			return false;
 
+		gStressTiers.push_back((size_t)count);
+		cursor = *end == ',' ? end + 1 : end;
+		if (*end != ',' && *end != '\0')
+			return false;
+	}
 
-	// Flips the the back buffer with the front buffer every frame (refresh)
-	glfwSwapBuffers(gWindow);
+	return !gStressTiers.empty();
 }
 
 //****************************************************
 //  const char* vtxShaderSource: vertex shader source code
 //  const char* fragShaderSource: fragment shader source code
-//  GLuint &programId: unique ID of program associated with shaders
+//  ShaderProgram &program: linked program and its reflected uniforms
 //****************************************************
-bool CreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, GLuint& programId)
+bool CreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, ShaderProgram& program)
 {
 	// Compilation and linkage error reporting
 	int success = 0;
 	char infoLog[512];
 
-	// Create a Shader program object.
-	programId = glCreateProgram();
-
 	// Create the vertex and fragment shader objects
 	GLuint vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
 	GLuint fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
@@ -1138,95 +1619,302 @@ bool CreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSour
 		return false;
 	}
 
-	// Attached compiled shaders to the shader program
-	glAttachShader(programId, vertexShaderId);
-	glAttachShader(programId, fragmentShaderId);
+	// Link the stages and reflect the active uniforms and uniform blocks
+	bool linked = program.Link(vertexShaderId, fragmentShaderId);
 
-	// Links the shader program
-	glLinkProgram(programId);
-	// Check for linking errors
-	glGetProgramiv(programId, GL_LINK_STATUS, &success);
-	if (!success)
-	{
-		glGetProgramInfoLog(programId, sizeof(infoLog), NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+	glDeleteShader(vertexShaderId);
+	glDeleteShader(fragmentShaderId);
+
+	if (!linked)
 		return false;
-	}
 
 	// Uses the shader program
-	glUseProgram(programId);
+	glUseProgram(program.id);
 
 	return true;
 }
 
 // Destroy the linked shader program //
-void DestroyShaderProgram(GLuint programId)
+void DestroyShaderProgram(ShaderProgram& program)
+{
+	program.Destroy();
+}
+
+// Resolve every surface shader uniform once, so Render() never looks up a name //
+void ResolveSurfaceUniforms()
+{
+	const ShaderProgram& program = gSurfaceProgram;
+
+	gSurfaceUniforms.texture = program.GetSampler("uTexture");
+
+	// The std140 mirrors in sceneData.h must match what the compiler laid out
+	const ShaderProgram::UniformBlockInfo* frameBlock = program.FindUniformBlock("FrameData");
+	if (frameBlock == nullptr || frameBlock->dataSize != (GLint)sizeof(GPUFrameData))
+		cout << "WARNING::SHADER::FrameData block does not match GPUFrameData" << endl;
+
+	const ShaderProgram::UniformBlockInfo* materialBlock = program.FindUniformBlock("MaterialData");
+	if (materialBlock == nullptr || materialBlock->dataSize != (GLint)sizeof(GPUMaterialData))
+		cout << "WARNING::SHADER::MaterialData block does not match GPUMaterialData" << endl;
+}
+
+// Upload the material table; each texture's layer is filled in again as it streams in //
+void CreateUniformBuffers()
+{
+	GPUMaterialData& materialData = gMaterialData;
+
+	// Every material in the scene shares the same specular response
+	for (int i = 0; i < MATERIAL_COUNT; ++i)
+	{
+		GPUMaterial& material = materialData.materials[i];
+		material.objectColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		material.uvScale = glm::vec2(1.0f, 1.0f);
+		material.ambientStrength = 0.0f;
+		material.textureLayer = gTextureSlots[MATERIAL_TEXTURES[i]].layer;
+		material.specularIntensity = glm::vec2(0.4f, 0.4f);
+		material.highlightSize = glm::vec2(2.0f, 32.0f);
+	}
+
+	materialData.materials[MATERIAL_BOWL_BASE].ambientStrength = 0.0f;
+	materialData.materials[MATERIAL_BOWL].ambientStrength = 0.5f;
+	materialData.materials[MATERIAL_CORK].ambientStrength = 1.0f;
+	materialData.materials[MATERIAL_BOTTLE_NECK].ambientStrength = 0.5f;
+	materialData.materials[MATERIAL_BOTTLE].ambientStrength = 0.0f;
+	materialData.materials[MATERIAL_TABLE].ambientStrength = 0.0f;
+	materialData.materials[MATERIAL_TABLE].specularIntensity = glm::vec2(1.0f, 0.4f);
+	materialData.materials[MATERIAL_ICE_CREAM].ambientStrength = 1.0f;
+	materialData.materials[MATERIAL_SPOON].ambientStrength = 2.0f;
+	materialData.materials[MATERIAL_SPOON_HANDLE].ambientStrength = 0.5f;
+
+	// Per-frame data is placed in the ring at this granularity
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &gUniformBufferAlignment);
+
+	gMaterialUniformBuffer.Create(MATERIAL_DATA_BINDING, sizeof(GPUMaterialData), &materialData);
+}
+
+// Release the uniform buffers //
+void DestroyUniformBuffers()
+{
+	gMaterialUniformBuffer.Destroy();
+}
+
+// Write the camera and lights for this frame into the FrameData block //
+void UpdateFrameUniforms(const glm::mat4& view, const glm::mat4& projection)
+{
+	RingBuffer::Allocation allocation = gFrameRing.Allocate(sizeof(GPUFrameData), gUniformBufferAlignment);
+	if (!allocation.IsValid())
+		return;
+
+	GPUFrameData frameData;
+
+	frameData.view = view;
+	frameData.projection = projection;
+	frameData.viewPosition = glm::vec4(gCamera.Position, 1.0f);
+	frameData.ambientColor = glm::vec4(0.1f, 0.1f, 0.1f, 1.0f);
+
+	// Key light
+	frameData.lights[0].position = glm::vec4(-0.5f, 1.0f, -1.0f, 1.0f);
+	frameData.lights[0].color = glm::vec4(1.0f, 0.8f, 0.8f, 1.0f);
+	// Fill light
+	frameData.lights[1].position = glm::vec4(0.5f, 1.0f, -1.0f, 1.0f);
+	frameData.lights[1].color = glm::vec4(0.8f, 1.0f, 0.8f, 1.0f);
+
+	// Write straight into mapped memory and point the block at it
+	memcpy(allocation.data, &frameData, sizeof(frameData));
+	glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, gFrameRing.id, allocation.offset, sizeof(frameData));
+}
+
+// Queue a load of every scene texture on the workers //
+void StartTextureDecodes()
+{
+	const struct { const char* filename; TextureId texture; } files[] = {
+		{ "../resources/textures/vanilla.jpg", TEXTURE_BLUE },
+		{ "../resources/textures/wood_table.jpg", TEXTURE_RED },
+		{ "../resources/textures/cork_texture.jpg", TEXTURE_BROWN },
+		{ "../resources/textures/label.jpg", TEXTURE_GREEN },
+		{ "../resources/textures/bottle.jpg", TEXTURE_YELLOW },
+		{ "../resources/textures/marble.jpg", TEXTURE_WHITE },
+		{ "../resources/textures/spoon.jpg", TEXTURE_SILVER },
+	};
+
+	// Cache entries cannot be copied, so the loads are filled in place
+	gTextureLoads.resize(sizeof(files) / sizeof(files[0]));
+	for (size_t i = 0; i < gTextureLoads.size(); ++i)
+	{
+		gTextureLoads[i].filename = files[i].filename;
+		gTextureLoads[i].slot = &gTextureSlots[files[i].texture];
+		gTextureLoads[i].asset = gStartup.AddAsset(files[i].filename);
+		gTextureLoads[i].loadStartMs = -1.0;
+		gTextureLoads[i].queued = false;
+		SubmitTextureLoad(i, true);
+	}
+}
+
+// Load one scene texture on a worker: the cooked file if wanted and present, else the image, //
+// scaled to the layer size, through the cache unless it is off                              //
+void SubmitTextureLoad(size_t index, bool useCooked)
+{
+	gWorkers.Submit([index, useCooked]()
+	{
+		TextureLoad& load = gTextureLoads[index];
+		if (load.loadStartMs < 0.0)
+			load.loadStartMs = gStartup.NowMs();
+
+		bool cooked = useCooked && LoadKtx2(CookedTexturePath(load.filename).c_str(), load.cooked);
+		if (!cooked)
+			TextureCache::Load(load.filename, TEXTURE_LAYER_SIZE, load.cached, gTextureCacheEnabled);
+		load.loadEndMs = gStartup.NowMs();
+
+		// A failed load is handed over too, so it gets reported
+		std::lock_guard<std::mutex> lock(gTextureLoadMutex);
+		gDecodedTextures.push_back(index);
+	});
+}
+
+// Create the staging ring and point every texture slot at the placeholder array //
+bool CreatePlaceholderTextures()
+{
+	if (!gTextureStreamer.Create(TEXTURE_STAGING_SIZE, TEXTURE_STREAM_BYTES_PER_FRAME))
+		return false;
+
+	gPlaceholderArray = CreateImmutableTexture2DArray(GL_RGBA8, 1, 1, 1, 1);
+	SetTextureArraySamplerState(gPlaceholderArray);
+	UploadTextureLayerRegion(gPlaceholderArray, 0, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_COLOR);
+
+	for (TextureSlot& slot : gTextureSlots)
+		slot = { gPlaceholderArray, 0 };
+
+	return true;
+}
+
+// Wrap and filter state shared by every texture array //
+void SetTextureArraySamplerState(GLuint array)
 {
-	glDeleteProgram(programId);
+	SetTextureArrayParameter(array, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	SetTextureArrayParameter(array, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	SetTextureArrayParameter(array, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	SetTextureArrayParameter(array, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
-// Images are loaded with Y axis going down, but OpenGL's Y axis goes up, so let's flip it //
-void flipImageVertically(unsigned char* image, int width, int height, int channels)
+// Queue every load finished so far into a layer of its array, then let the streamer //
+// upload, and point the materials at the layers it finished                         //
+void StreamDecodedTextures()
 {
-	for (int j = 0; j < height / 2; ++j)
+	PROFILE_ZONE("StreamTextures");
+
+	std::deque<size_t> decoded;
 	{
-		int index1 = j * width * channels;
-		int index2 = (height - 1 - j) * width * channels;
+		std::lock_guard<std::mutex> lock(gTextureLoadMutex);
+		decoded.swap(gDecodedTextures);
+	}
 
-		for (int i = width * channels; i > 0; --i)
+	for (size_t index : decoded)
+	{
+		TextureLoad& load = gTextureLoads[index];
+		GLint layer;
+
+		if (!load.cooked.levels.empty())
 		{
-			unsigned char tmp = image[index1];
-			image[index1] = image[index2];
-			image[index2] = tmp;
-			++index1;
-			++index2;
+			if (HasCompressedFormat(load.cooked.internalFormat))
+			{
+				GLuint array = AllocateTextureLayer(load.cooked.internalFormat, load.cooked.width, load.cooked.height,
+					(GLsizei)load.cooked.levels.size(), layer);
+				gTextureStreamer.Queue(load.slot, array, layer, std::move(load.cooked));
+				gStartup.SetAssetLoad(load.asset, load.loadStartMs, load.loadEndMs, false);
+				load.queued = true;
+				continue;
+			}
+
+			// The driver cannot sample this format; fall back to the source image
+			cout << "WARNING: compressed format of " << load.filename << " not supported, decoding the image" << endl;
+			load.cooked = CompressedTexture();
+			SubmitTextureLoad(index, false);
+			continue;
 		}
+
+		if (!load.cached.levels.empty())
+		{
+			GLuint array = AllocateTextureLayer(load.cached.format == GL_RGB ? GL_RGB8 : GL_RGBA8, load.cached.width, load.cached.height,
+				(GLsizei)load.cached.levels.size(), layer);
+			gTextureStreamer.Queue(load.slot, array, layer, std::move(load.cached));
+			gStartup.SetAssetLoad(load.asset, load.loadStartMs, load.loadEndMs, false);
+			load.queued = true;
+			continue;
+		}
+
+		// The placeholder stays in the slot of a file that failed to load
+		cout << "Failed to load texture " << load.filename << endl;
+		gStartup.SetAssetLoad(load.asset, load.loadStartMs, load.loadEndMs, true);
 	}
+
+	gTextureStreamer.Update();
+	UpdateMaterialTextures();
+
+	// A slot off the placeholder has its layer swapped in
+	for (TextureLoad& load : gTextureLoads)
+	{
+		if (load.queued && load.slot->array != gPlaceholderArray)
+		{
+			gStartup.MarkAssetReady(load.asset);
+			load.queued = false;
+		}
+	}
+
+	if (!gStartupAssetsReported && gStartup.IsComplete() && gStartup.AssetsSettled())
+		ReportStartupAssets();
 }
 
-// Generate and load the texture //
-bool CreateTexture(const char* filename, GLuint& textureId)
+// Hand out the next layer of the array for this format and size, creating the array, //
+// with a layer for every scene texture, the first time the format and size come up   //
+GLuint AllocateTextureLayer(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei levels, GLint& layer)
 {
-	int width, height, channels;
-	unsigned char *image = stbi_load(filename, &width, &height, &channels, 0);
-	if (image)
+	for (TextureArray& array : gTextureArrays)
 	{
-		flipImageVertically(image, width, height, channels);
-
-		glGenTextures(1, &textureId);
-		glBindTexture(GL_TEXTURE_2D, textureId);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		if (channels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		else if (channels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
+		if (array.internalFormat == internalFormat && array.width == width && array.height == height && array.levels == levels)
 		{
-			cout << "Not implemented to handle image with " << channels << " channels" << endl;
-			return false;
+			layer = array.nextLayer++;
+			return array.id;
 		}
+	}
 
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	// Every array past the first splits the scene's draws; cooking all textures alike avoids it
+	if (!gTextureArrays.empty())
+		cout << "WARNING: scene textures need " << gTextureArrays.size() + 1 << " texture arrays, one per format and size" << endl;
+
+	TextureArray array;
+	array.id = CreateImmutableTexture2DArray(internalFormat, width, height, (GLsizei)gTextureLoads.size(), levels);
+	array.internalFormat = internalFormat;
+	array.width = width;
+	array.height = height;
+	array.levels = levels;
+	array.nextLayer = 1;
+	SetTextureArraySamplerState(array.id);
+	gTextureArrays.push_back(array);
+
+	layer = 0;
+	return array.id;
+}
 
-		return true;
+// Write each material's layer into the material table once its texture moved to a new one //
+void UpdateMaterialTextures()
+{
+	bool changed = false;
+	for (int i = 0; i < MATERIAL_COUNT; ++i)
+	{
+		GLint layer = gTextureSlots[MATERIAL_TEXTURES[i]].layer;
+		if (gMaterialData.materials[i].textureLayer != layer)
+		{
+			gMaterialData.materials[i].textureLayer = layer;
+			changed = true;
+		}
 	}
 
-	// Error loading the image
-	return false;
+	// The array itself is picked per draw from the same slot, so both change in the same frame
+	if (changed)
+		gMaterialUniformBuffer.Update(&gMaterialData, sizeof(GPUMaterialData), 0);
 }
 
 // Release the texture attached to textureId //
-void DestroyTexture(GLuint textureId)
+void DestroyTexture(GLuint& textureId)
 {
-	glGenTextures(1, &textureId);
+	DeleteTexture(textureId);
 }
\ No newline at end of file
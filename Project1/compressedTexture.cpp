@@ -0,0 +1,373 @@
+///////////////////////////////////////////////////////////////////////////////
+// compressedTexture.cpp
+// ========
+// block-compressed textures with a full mip chain, in KTX2 files
+///////////////////////////////////////////////////////////////////////////////
+
+#include "compressedTexture.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	// Identifier, nine header words, then the index of the DFD, KVD and SGD
+	const size_t HEADER_BYTES = 80;
+	const size_t LEVEL_INDEX_ENTRY_BYTES = 24;
+
+	// Khronos data format descriptor values of the block formats
+	const uint32_t KHR_DF_MODEL_BC1A = 128;
+	const uint32_t KHR_DF_MODEL_BC3 = 130;
+	const uint32_t KHR_DF_MODEL_BC7 = 134;
+	const uint32_t KHR_DF_CHANNEL_COLOR = 0;
+	const uint32_t KHR_DF_CHANNEL_BC3_ALPHA = 15;
+	const uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+	const uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+
+	// The formats the cooker writes and the renderer loads
+	struct FormatInfo
+	{
+		GLenum internalFormat;
+		uint32_t vkFormat;
+		GLsizei blockBytes;
+		uint32_t colorModel;
+	};
+
+	const FormatInfo FORMATS[] = {
+		{ GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 131, 8, KHR_DF_MODEL_BC1A },     // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+		{ GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 137, 16, KHR_DF_MODEL_BC3 },    // VK_FORMAT_BC3_UNORM_BLOCK
+		{ GL_COMPRESSED_RGBA_BPTC_UNORM, 145, 16, KHR_DF_MODEL_BC7 },       // VK_FORMAT_BC7_UNORM_BLOCK
+	};
+
+	const FormatInfo* FindFormat(GLenum internalFormat)
+	{
+		for (const FormatInfo& format : FORMATS)
+			if (format.internalFormat == internalFormat)
+				return &format;
+		return NULL;
+	}
+
+	// Levels of a full chain down to 1x1, the same count as MipLevelCount() in glResources
+	uint32_t FullChainLevels(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+			++levels;
+		return levels;
+	}
+
+	const FormatInfo* FindVkFormat(uint32_t vkFormat)
+	{
+		for (const FormatInfo& format : FORMATS)
+			if (format.vkFormat == vkFormat)
+				return &format;
+		return NULL;
+	}
+
+	size_t Align(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// KTX2 is little-endian, as is every platform this builds for
+	void Put32(std::vector<unsigned char>& out, uint32_t value)
+	{
+		out.insert(out.end(), (const unsigned char*)&value, (const unsigned char*)&value + sizeof(value));
+	}
+
+	void Put64(std::vector<unsigned char>& out, uint64_t value)
+	{
+		out.insert(out.end(), (const unsigned char*)&value, (const unsigned char*)&value + sizeof(value));
+	}
+
+	uint32_t Get32(const unsigned char* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	uint64_t Get64(const unsigned char* data)
+	{
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	// Basic data format descriptor: one 64-bit sample per 8 bytes of block
+	std::vector<unsigned char> DataFormatDescriptor(const FormatInfo& format)
+	{
+		struct Sample { uint32_t channel; uint32_t bitOffset; uint32_t bitLength; };
+		Sample samples[2] = { { KHR_DF_CHANNEL_COLOR, 0, (uint32_t)format.blockBytes * 8 } };
+		uint32_t sampleCount = 1;
+		if (format.colorModel == KHR_DF_MODEL_BC3)
+		{
+			samples[0] = { KHR_DF_CHANNEL_BC3_ALPHA, 0, 64 };
+			samples[1] = { KHR_DF_CHANNEL_COLOR, 64, 64 };
+			sampleCount = 2;
+		}
+
+		uint32_t blockSize = 24 + 16 * sampleCount;
+
+		std::vector<unsigned char> dfd;
+		Put32(dfd, 4 + blockSize);                  // dfdTotalSize
+		Put32(dfd, 0);                              // Khronos vendor, basic descriptor type
+		Put32(dfd, 2 | (blockSize << 16));          // Version 2
+		Put32(dfd, format.colorModel | (KHR_DF_PRIMARIES_BT709 << 8) | (KHR_DF_TRANSFER_LINEAR << 16));
+		Put32(dfd, 3 | (3 << 8));                   // 4x4x1x1 texel blocks
+		Put32(dfd, (uint32_t)format.blockBytes);    // One plane
+		Put32(dfd, 0);
+
+		for (uint32_t i = 0; i < sampleCount; ++i)
+		{
+			const Sample& sample = samples[i];
+			Put32(dfd, sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24));
+			Put32(dfd, 0);                          // Sample position
+			Put32(dfd, 0);                          // Lower
+			Put32(dfd, 0xFFFFFFFFu);                // Upper
+		}
+		return dfd;
+	}
+
+	// One key/value entry, padded to 4 bytes
+	void PutKeyValue(std::vector<unsigned char>& out, const char* key, const char* value)
+	{
+		uint32_t keyBytes = (uint32_t)strlen(key) + 1;
+		uint32_t valueBytes = (uint32_t)strlen(value) + 1;
+
+		Put32(out, keyBytes + valueBytes);
+		out.insert(out.end(), key, key + keyBytes);
+		out.insert(out.end(), value, value + valueBytes);
+		out.resize(Align(out.size(), 4), 0);
+	}
+
+	// Value of a key in the key/value data, NULL when absent
+	const char* FindValue(const unsigned char* kvd, size_t length, const char* key)
+	{
+		size_t offset = 0;
+		while (offset + 4 <= length)
+		{
+			uint32_t entryBytes = Get32(kvd + offset);
+			const char* entry = (const char*)kvd + offset + 4;
+			if (entryBytes > length - offset - 4)
+				break;
+
+			size_t keyBytes = strnlen(entry, entryBytes);
+			if (keyBytes < entryBytes && strcmp(entry, key) == 0)
+			{
+				const char* value = entry + keyBytes + 1;
+				if (strnlen(value, entryBytes - keyBytes - 1) < entryBytes - keyBytes - 1)
+					return value;
+				break;
+			}
+			offset = Align(offset + 4 + entryBytes, 4);
+		}
+		return NULL;
+	}
+
+	bool Unusable(const char* error, const char* path, CompressedTexture& texture)
+	{
+		std::cout << "ERROR::KTX2::" << error << " " << path << std::endl;
+		texture = CompressedTexture();
+		return false;
+	}
+}
+
+GLsizei CompressedBlockBytes(GLenum internalFormat)
+{
+	const FormatInfo* format = FindFormat(internalFormat);
+	return format ? format->blockBytes : 0;
+}
+
+size_t CompressedLevelBytes(GLenum internalFormat, GLsizei width, GLsizei height)
+{
+	size_t blocksWide = (width + 3) / 4;
+	size_t blocksHigh = (height + 3) / 4;
+	return blocksWide * blocksHigh * CompressedBlockBytes(internalFormat);
+}
+
+std::string CookedTexturePath(const char* imagePath)
+{
+	std::string path = imagePath;
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+		path.erase(dot);
+	return path + ".ktx2";
+}
+
+///////////////////////////////////////////////////
+//	LoadKtx2(const char*, CompressedTexture&)
+//
+//	path: file written by the TextureCooker
+//	texture: receives the file; its levels point
+//	straight into the data read
+//
+//	Only single 2D images in the formats above,
+//	stored bottom row first, are accepted
+///////////////////////////////////////////////////
+bool LoadKtx2(const char* path, CompressedTexture& texture)
+{
+	texture = CompressedTexture();
+
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	bool read = size > 0;
+	if (read)
+	{
+		texture.data.resize((size_t)size);
+		read = fread(texture.data.data(), 1, texture.data.size(), file) == texture.data.size();
+	}
+	fclose(file);
+
+	const unsigned char* data = texture.data.data();
+	if (!read || texture.data.size() < HEADER_BYTES || memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		return Unusable("NOT_A_KTX2_FILE", path, texture);
+
+	uint32_t vkFormat = Get32(data + 12);
+	uint32_t width = Get32(data + 20);
+	uint32_t height = Get32(data + 24);
+	uint32_t depth = Get32(data + 28);
+	uint32_t layerCount = Get32(data + 32);
+	uint32_t faceCount = Get32(data + 36);
+	uint32_t levelCount = Get32(data + 40);
+	uint32_t supercompression = Get32(data + 44);
+	uint32_t kvdOffset = Get32(data + 56);
+	uint32_t kvdLength = Get32(data + 60);
+
+	const FormatInfo* format = FindVkFormat(vkFormat);
+	if (!format || width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX || depth != 0 ||
+		layerCount > 1 || faceCount != 1 || supercompression != 0)
+		return Unusable("UNSUPPORTED_TEXTURE", path, texture);
+
+	// Bounded before anything is sized from it: a longer chain cannot be allocated by
+	// glTexStorage, and its level index could overflow the size check below
+	if (levelCount == 0 || levelCount > FullChainLevels(width, height))
+		return Unusable("BAD_LEVEL_COUNT", path, texture);
+
+	if (HEADER_BYTES + levelCount * LEVEL_INDEX_ENTRY_BYTES > texture.data.size() ||
+		(size_t)kvdOffset + kvdLength > texture.data.size())
+		return Unusable("TRUNCATED", path, texture);
+
+	// Block rows cannot be flipped cheaply, so the file must already be in GL's order
+	const char* orientation = FindValue(data + kvdOffset, kvdLength, "KTXorientation");
+	if (!orientation || strncmp(orientation, "ru", 2) != 0)
+		return Unusable("NOT_BOTTOM_UP", path, texture);
+
+	texture.internalFormat = format->internalFormat;
+	texture.width = (GLsizei)width;
+	texture.height = (GLsizei)height;
+
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		const unsigned char* entry = data + HEADER_BYTES + level * LEVEL_INDEX_ENTRY_BYTES;
+		uint64_t offset = Get64(entry);
+		uint64_t length = Get64(entry + 8);
+
+		GLsizei levelWidth = std::max(1, texture.width >> level);
+		GLsizei levelHeight = std::max(1, texture.height >> level);
+		if (length != CompressedLevelBytes(texture.internalFormat, levelWidth, levelHeight) ||
+			offset > texture.data.size() || length > texture.data.size() - offset)
+			return Unusable("TRUNCATED", path, texture);
+
+		texture.levels.push_back({ (size_t)offset, (size_t)length });
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	WriteKtx2(const char*, const CompressedTexture&)
+//
+//	path: file to create
+//	texture: every level of one 2D image, bottom
+//	row first
+//
+//	Levels are stored smallest first, as KTX2 lays
+//	them out
+///////////////////////////////////////////////////
+bool WriteKtx2(const char* path, const CompressedTexture& texture)
+{
+	const FormatInfo* format = FindFormat(texture.internalFormat);
+	if (!format || texture.levels.empty())
+	{
+		std::cout << "ERROR::KTX2::UNSUPPORTED_TEXTURE " << path << std::endl;
+		return false;
+	}
+
+	uint32_t levelCount = (uint32_t)texture.levels.size();
+	std::vector<unsigned char> dfd = DataFormatDescriptor(*format);
+
+	// Keys in byte order
+	std::vector<unsigned char> kvd;
+	PutKeyValue(kvd, "KTXorientation", "ru");
+	PutKeyValue(kvd, "KTXwriter", "TextureCooker");
+
+	size_t dfdOffset = HEADER_BYTES + levelCount * LEVEL_INDEX_ENTRY_BYTES;
+	size_t kvdOffset = dfdOffset + dfd.size();
+
+	std::vector<uint64_t> levelOffsets(levelCount);
+	size_t end = kvdOffset + kvd.size();
+	for (uint32_t level = levelCount; level-- > 0;)
+	{
+		levelOffsets[level] = Align(end, format->blockBytes);
+		end = levelOffsets[level] + texture.levels[level].size;
+	}
+
+	std::vector<unsigned char> out(KTX2_IDENTIFIER, KTX2_IDENTIFIER + sizeof(KTX2_IDENTIFIER));
+	Put32(out, format->vkFormat);
+	Put32(out, 1);                                  // typeSize of block formats
+	Put32(out, (uint32_t)texture.width);
+	Put32(out, (uint32_t)texture.height);
+	Put32(out, 0);                                  // pixelDepth
+	Put32(out, 0);                                  // layerCount
+	Put32(out, 1);                                  // faceCount
+	Put32(out, levelCount);
+	Put32(out, 0);                                  // No supercompression
+	Put32(out, (uint32_t)dfdOffset);
+	Put32(out, (uint32_t)dfd.size());
+	Put32(out, (uint32_t)kvdOffset);
+	Put32(out, (uint32_t)kvd.size());
+	Put64(out, 0);                                  // No supercompression global data
+	Put64(out, 0);
+
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		Put64(out, levelOffsets[level]);
+		Put64(out, texture.levels[level].size);
+		Put64(out, texture.levels[level].size);
+	}
+
+	out.insert(out.end(), dfd.begin(), dfd.end());
+	out.insert(out.end(), kvd.begin(), kvd.end());
+
+	for (uint32_t level = levelCount; level-- > 0;)
+	{
+		const TextureLevel& source = texture.levels[level];
+		out.resize((size_t)levelOffsets[level], 0);
+		out.insert(out.end(), texture.data.begin() + source.offset, texture.data.begin() + source.offset + source.size);
+	}
+
+	FILE* file = fopen(path, "wb");
+	bool written = file && fwrite(out.data(), 1, out.size(), file) == out.size();
+	if (file)
+		written = fclose(file) == 0 && written;
+
+	if (!written)
+	{
+		std::cout << "ERROR::KTX2::CANNOT_WRITE " << path << std::endl;
+		return false;
+	}
+	return true;
+}
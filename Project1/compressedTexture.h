@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// compressedTexture.h
+// ========
+// block-compressed textures with a full mip chain, in KTX2 files
+//
+// The TextureCooker tool turns the JPEG textures into BC1, BC3 or BC7 KTX2
+// files next to their source images; at startup the renderer loads these
+// instead of decoding the JPEGs. A cooked texture needs no decode, no flip
+// and no mip generation: every level is stored ready for
+// glCompressedTexSubImage2D, bottom row first (KTXorientation "ru"), and
+// takes a quarter to an eighth of the memory of GL_RGB8 / GL_RGBA8.
+//
+// Only the CPU side lives here; nothing in this file calls OpenGL, so the
+// cooker links it without a context.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+// One mip level of a stored texture, as a range of its data
+struct TextureLevel
+{
+	size_t offset;
+	size_t size;
+};
+
+struct CompressedTexture
+{
+	GLenum internalFormat = 0;          // GL_COMPRESSED_* format of every level, 0 when empty
+	GLsizei width = 0;
+	GLsizei height = 0;
+	std::vector<TextureLevel> levels;   // Level 0 first
+	std::vector<unsigned char> data;
+};
+
+// Bytes per 4x4 block of a supported format, 0 for any other
+GLsizei CompressedBlockBytes(GLenum internalFormat);
+
+// Bytes of one width x height level of a supported format
+size_t CompressedLevelBytes(GLenum internalFormat, GLsizei width, GLsizei height);
+
+// The cooked file of a source image: the same path with the extension .ktx2
+std::string CookedTexturePath(const char* imagePath);
+
+// Read a KTX2 file into texture; safe to run on any thread. False if the file
+// is missing or unusable; anything other than a missing file is reported.
+bool LoadKtx2(const char* path, CompressedTexture& texture);
+
+// Write texture as a KTX2 file
+bool WriteKtx2(const char* path, const CompressedTexture& texture);
@@ -0,0 +1,274 @@
+///////////////////////////////////////////////////////////////////////////////
+// cpuProfiler.cpp
+// ========
+// scoped CPU zones recorded into per-thread rings, exported as Chrome trace
+///////////////////////////////////////////////////////////////////////////////
+
+#include "cpuProfiler.h"
+
+#if CPU_PROFILER_ENABLED
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Events kept per thread; a power of two so the head wraps with a mask
+	const uint64_t RING_SIZE = 1u << 16;
+	const uint64_t RING_MASK = RING_SIZE - 1;
+
+	struct Event
+	{
+		const char* name;
+		int64_t start;
+		int64_t end;
+	};
+
+	// Written only by its own thread; read by whoever exports a trace
+	struct ThreadRing
+	{
+		Event events[RING_SIZE];
+		std::atomic<uint64_t> head{ 0 };    // Number of events ever written
+		const char* name = NULL;
+		unsigned int id = 0;
+	};
+
+	// Rings are registered once per thread and outlive their threads, so
+	// zones of workers that already exited still reach the trace
+	std::mutex gRegistryMutex;
+	std::vector<std::unique_ptr<ThreadRing>> gRings;
+
+	thread_local ThreadRing* tRing = NULL;
+
+	// Frame counter and pending capture, driven by the main thread
+	uint64_t gFrameIndex = 0;
+	std::string gCapturePath;
+	uint64_t gCaptureFirst = 0;
+	uint64_t gCaptureEnd = 0;
+	int64_t gCaptureBegin = 0;
+	bool gCapturePending = false;
+
+	ThreadRing& LocalRing()
+	{
+		if (!tRing)
+		{
+			std::lock_guard<std::mutex> lock(gRegistryMutex);
+			gRings.emplace_back(new ThreadRing());
+			tRing = gRings.back().get();
+			tRing->id = (unsigned int)gRings.size();
+		}
+		return *tRing;
+	}
+
+	// Copy the events of a ring that are still intact. The writer keeps
+	// going while this reads, so events it overwrote meanwhile are dropped,
+	// along with the slot of the event it may be writing but not published.
+	void ReadRing(const ThreadRing& ring, std::vector<Event>& events)
+	{
+		events.clear();
+
+		uint64_t head = ring.head.load(std::memory_order_acquire);
+		uint64_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+		for (uint64_t i = first; i < head; ++i)
+			events.push_back(ring.events[i & RING_MASK]);
+
+		uint64_t newHead = ring.head.load(std::memory_order_acquire);
+		uint64_t intact = newHead + 1 > RING_SIZE ? newHead + 1 - RING_SIZE : 0;
+		if (intact > first)
+			events.erase(events.begin(), events.begin() + (size_t)std::min(intact - first, (uint64_t)events.size()));
+	}
+
+	// Write the pending capture up to the end of frame lastFrame
+	void WriteCapture(uint64_t lastFrame, int64_t end)
+	{
+		if (CpuProfiler::WriteChromeTrace(gCapturePath.c_str(), gCaptureBegin, end))
+			std::cout << "INFO: CPU trace of frames " << gCaptureFirst << "-" << lastFrame
+				<< " written to " << gCapturePath << std::endl;
+		gCapturePending = false;
+	}
+
+	void WriteJsonString(std::ostream& out, const char* text)
+	{
+		out << '"';
+		for (const char* c = text; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+				out << '\\';
+			out << *c;
+		}
+		out << '"';
+	}
+}
+
+int64_t CpuProfiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CpuProfiler::SetThreadName(const char* name)
+{
+	LocalRing().name = name;
+}
+
+///////////////////////////////////////////////////
+//	Record(const char*, int64_t, int64_t)
+//
+//	Store a zone in the calling thread's ring and
+//	publish it to readers
+///////////////////////////////////////////////////
+void CpuProfiler::Record(const char* name, int64_t start, int64_t end)
+{
+	ThreadRing& ring = LocalRing();
+
+	uint64_t head = ring.head.load(std::memory_order_relaxed);
+	Event& event = ring.events[head & RING_MASK];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////
+//	MarkFrame()
+//
+//	Start the next frame. Opens the capture window
+//	on its first frame and writes the trace once
+//	its last frame has ended.
+///////////////////////////////////////////////////
+void CpuProfiler::MarkFrame()
+{
+	int64_t now = Now();
+
+	if (gCapturePending)
+	{
+		if (gFrameIndex == gCaptureFirst)
+			gCaptureBegin = now;
+		else if (gFrameIndex == gCaptureEnd)
+			WriteCapture(gCaptureEnd - 1, now);
+	}
+
+	++gFrameIndex;
+}
+
+///////////////////////////////////////////////////
+//	Capture(const char*, uint64_t, uint64_t, uint64_t)
+//
+//	path: JSON file to write
+//	firstFrame, frameCount: window of frames
+//	frameLimit: frames in the run, 0 if unknown
+//
+//	Arm the capture, moving a window that starts
+//	or ends past the last frame back inside it
+///////////////////////////////////////////////////
+void CpuProfiler::Capture(const char* path, uint64_t firstFrame, uint64_t frameCount, uint64_t frameLimit)
+{
+	frameCount = std::max(frameCount, (uint64_t)1);
+	firstFrame = std::max(firstFrame, gFrameIndex);
+
+	if (frameLimit > 0 && firstFrame + frameCount > frameLimit)
+	{
+		uint64_t count = std::min(frameCount, frameLimit);
+		uint64_t first = std::max(frameLimit - count, gFrameIndex);
+		std::cout << "WARNING: CPU trace of frames " << firstFrame << "-" << firstFrame + frameCount - 1
+			<< " is past the last frame " << frameLimit - 1 << ", tracing frames " << first << "-" << frameLimit - 1
+			<< " instead" << std::endl;
+		firstFrame = first;
+		frameCount = frameLimit - first;
+	}
+
+	gCapturePath = path;
+	gCaptureFirst = firstFrame;
+	gCaptureEnd = firstFrame + frameCount;
+	gCapturePending = true;
+}
+
+///////////////////////////////////////////////////
+//	FinishCapture()
+//
+//	Write the frames of a pending capture that did
+//	run, once the last frame is over; the window's
+//	end frame never gets its MarkFrame when the run
+//	stops with it
+///////////////////////////////////////////////////
+void CpuProfiler::FinishCapture()
+{
+	if (!gCapturePending)
+		return;
+
+	if (gFrameIndex <= gCaptureFirst)
+	{
+		std::cout << "WARNING: the run ended at frame " << gFrameIndex << " before the CPU trace of frames "
+			<< gCaptureFirst << "-" << gCaptureEnd - 1 << " began; nothing written to " << gCapturePath << std::endl;
+		gCapturePending = false;
+		return;
+	}
+
+	if (gFrameIndex < gCaptureEnd)
+		std::cout << "WARNING: the run ended at frame " << gFrameIndex << ", inside the CPU trace of frames "
+			<< gCaptureFirst << "-" << gCaptureEnd - 1 << std::endl;
+	WriteCapture(std::min(gFrameIndex, gCaptureEnd) - 1, Now());
+}
+
+///////////////////////////////////////////////////
+//	WriteChromeTrace(const char*, int64_t, int64_t)
+//
+//	path: JSON file to write
+//	begin, end: time window, from Now()
+//
+//	Export the zones of every thread that overlap
+//	the window as complete ("X") events
+///////////////////////////////////////////////////
+bool CpuProfiler::WriteChromeTrace(const char* path, int64_t begin, int64_t end)
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cout << "ERROR::CPU_PROFILER::CANNOT_WRITE " << path << std::endl;
+		return false;
+	}
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	bool first = true;
+	std::vector<Event> events;
+
+	std::lock_guard<std::mutex> lock(gRegistryMutex);
+	for (const std::unique_ptr<ThreadRing>& ring : gRings)
+	{
+		if (ring->name)
+		{
+			file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->id
+				<< ",\"args\":{\"name\":";
+			WriteJsonString(file, ring->name);
+			file << "}}";
+			first = false;
+		}
+
+		ReadRing(*ring, events);
+		for (const Event& event : events)
+		{
+			if (event.end < begin || event.start > end)
+				continue;
+
+			// Chrome trace times are in microseconds
+			file << (first ? "" : ",\n") << "{\"name\":";
+			WriteJsonString(file, event.name);
+			file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->id
+				<< ",\"ts\":" << (event.start - begin) / 1000.0
+				<< ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+			first = false;
+		}
+	}
+
+	file << "\n]}\n";
+	return true;
+}
+
+#endif
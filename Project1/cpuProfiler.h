@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// cpuProfiler.h
+// ========
+// scoped CPU zones recorded into per-thread rings, exported as Chrome trace
+//
+// PROFILE_ZONE("name") times the rest of the enclosing C++ scope. Every
+// thread writes its zones into its own ring buffer, so recording takes no
+// lock: the thread is the only writer and publishes each event with a
+// release store of the ring head. The oldest events are overwritten once
+// a ring is full.
+//
+// PROFILE_FRAME() marks the start of a frame on the main thread. A capture
+// started with PROFILE_CAPTURE(path, firstFrame, frameCount) writes every
+// zone of every thread that falls within those frames to a Chrome trace
+// JSON file (chrome://tracing, ui.perfetto.dev) as soon as the last
+// frame ends. A run that stops inside the window calls
+// PROFILE_FINISH_CAPTURE() to write the frames it got to.
+//
+// Define CPU_PROFILER_ENABLED to 0 to compile every marker out.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifndef CPU_PROFILER_ENABLED
+#define CPU_PROFILER_ENABLED 1
+#endif
+
+#if CPU_PROFILER_ENABLED
+
+#include <cstdint>
+
+namespace CpuProfiler
+{
+	// Nanoseconds on a monotonic clock
+	int64_t Now();
+
+	// Name the calling thread in the trace; the name must outlive the profiler
+	void SetThreadName(const char* name);
+
+	// Append a finished zone to the calling thread's ring
+	void Record(const char* name, int64_t start, int64_t end);
+
+	// Advance the frame counter; writes the pending capture once it is complete
+	void MarkFrame();
+
+	// Trace frames [firstFrame, firstFrame + frameCount) into path. With a
+	// frameLimit, the number of frames the run will have (0 if unknown), a
+	// window that does not fit is moved back inside it.
+	void Capture(const char* path, uint64_t firstFrame, uint64_t frameCount, uint64_t frameLimit);
+
+	// The run is over: write a capture still pending, or warn it never began
+	void FinishCapture();
+
+	// Write zones recorded between two Now() times, from every thread
+	bool WriteChromeTrace(const char* path, int64_t begin, int64_t end);
+
+	// Times the enclosing C++ scope
+	class Zone
+	{
+	public:
+		explicit Zone(const char* name) : mName(name), mStart(Now()) {}
+		~Zone() { Record(mName, mStart, Now()); }
+
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+
+	private:
+		const char* mName;
+		int64_t mStart;
+	};
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define PROFILE_ZONE(name) CpuProfiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD(name) CpuProfiler::SetThreadName(name)
+#define PROFILE_FRAME() CpuProfiler::MarkFrame()
+#define PROFILE_CAPTURE(path, firstFrame, frameCount, frameLimit) CpuProfiler::Capture(path, firstFrame, frameCount, frameLimit)
+#define PROFILE_FINISH_CAPTURE() CpuProfiler::FinishCapture()
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_CAPTURE(path, firstFrame, frameCount, frameLimit) ((void)0)
+#define PROFILE_FINISH_CAPTURE() ((void)0)
+
+#endif
@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+// framePacer.cpp
+// ========
+// explicit frame pacing and rolling frame-time statistics
+///////////////////////////////////////////////////////////////////////////////
+
+#include "framePacer.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	// Below this much remaining time the wait spins instead of sleeping;
+	// covers the typical oversleep of a 1 ms OS sleep
+	const std::chrono::microseconds SPIN_THRESHOLD(2000);
+	const std::chrono::milliseconds SLEEP_STEP(1);
+
+	// Nearest-rank percentile of an unsorted sample set; reorders samples
+	double Percentile(std::vector<double>& samples, double fraction)
+	{
+		size_t rank = (size_t)(fraction * (samples.size() - 1) + 0.5);
+		std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+		return samples[rank];
+	}
+}
+
+///////////////////////////////////////////////////
+//	Configure(Mode, double, bool)
+//
+//	mode: pacing mode
+//	targetFps: frame rate held by PACING_FIXED
+//	presents: false when nothing is ever swapped
+//
+//	Set the swap interval for the mode and restart
+//	the frame deadlines. Needs a current GLFW
+//	context when presenting.
+///////////////////////////////////////////////////
+void FramePacer::Configure(Mode mode, double targetFps, bool presents)
+{
+	mMode = mode;
+	mTargetFps = targetFps > 0.0 ? targetFps : 60.0;
+	mFramePeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / mTargetFps));
+
+	if (presents)
+		glfwSwapInterval(mMode == PACING_VSYNC ? 1 : 0);
+
+	mStarted = false;
+}
+
+///////////////////////////////////////////////////
+//	EndFrame()
+//
+//	Hold the frame to its deadline when pacing to a
+//	fixed rate and store how long the frame took
+///////////////////////////////////////////////////
+void FramePacer::EndFrame()
+{
+	if (!mStarted)
+	{
+		// The first call only opens the first measured frame
+		mFrameStart = Clock::now();
+		mDeadline = mFrameStart + mFramePeriod;
+		mStarted = true;
+		return;
+	}
+
+	if (mMode == PACING_FIXED)
+	{
+		WaitUntil(mDeadline);
+
+		// A frame that overran by more than a whole period restarts the
+		// schedule instead of rushing the next frames to catch up
+		Clock::time_point now = Clock::now();
+		mDeadline += mFramePeriod;
+		if (mDeadline < now)
+			mDeadline = now + mFramePeriod;
+	}
+
+	Clock::time_point frameEnd = Clock::now();
+	double milliseconds = std::chrono::duration<double, std::milli>(frameEnd - mFrameStart).count();
+	mFrameStart = frameEnd;
+
+	if (mFrameTimes.size() < WINDOW_SIZE)
+		mFrameTimes.push_back(milliseconds);
+	else
+		mFrameTimes[mNextSample] = milliseconds;
+	mNextSample = (mNextSample + 1) % WINDOW_SIZE;
+}
+
+///////////////////////////////////////////////////
+//	Report()
+//
+//	Percentiles of the frames in the rolling window
+///////////////////////////////////////////////////
+FramePacer::Percentiles FramePacer::Report() const
+{
+	Percentiles report = {};
+	report.samples = mFrameTimes.size();
+	if (mFrameTimes.empty())
+		return report;
+
+	std::vector<double> samples = mFrameTimes;
+	report.p50 = Percentile(samples, 0.50);
+	report.p95 = Percentile(samples, 0.95);
+	report.p99 = Percentile(samples, 0.99);
+	report.max = *std::max_element(samples.begin(), samples.end());
+	return report;
+}
+
+bool FramePacer::ParseMode(const char* name, Mode& mode)
+{
+	if (strcmp(name, "uncapped") == 0)
+		mode = PACING_UNCAPPED;
+	else if (strcmp(name, "vsync") == 0)
+		mode = PACING_VSYNC;
+	else if (strcmp(name, "fixed") == 0)
+		mode = PACING_FIXED;
+	else
+		return false;
+	return true;
+}
+
+const char* FramePacer::ModeName(Mode mode)
+{
+	switch (mode)
+	{
+	case PACING_UNCAPPED: return "uncapped";
+	case PACING_VSYNC: return "vsync";
+	case PACING_FIXED: return "fixed";
+	}
+	return "unknown";
+}
+
+///////////////////////////////////////////////////
+//	WaitUntil(Clock::time_point)
+//
+//	Hybrid wait: coarse sleeps while the deadline is
+//	far away, then a spin for the last stretch
+///////////////////////////////////////////////////
+void FramePacer::WaitUntil(Clock::time_point deadline)
+{
+	while (deadline - Clock::now() > SPIN_THRESHOLD)
+		std::this_thread::sleep_for(SLEEP_STEP);
+
+	while (Clock::now() < deadline)
+		std::this_thread::yield();
+}
@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// framePacer.h
+// ========
+// explicit frame pacing and rolling frame-time statistics
+//
+// Three modes:
+//	uncapped	swap interval 0, no waiting; for benchmarking
+//	vsync		swap interval 1, the display paces the loop
+//	fixed		swap interval 0, the loop waits for a fixed target frame
+//				time: it sleeps while far from the deadline and spins
+//				through the last stretch, since OS sleeps overshoot
+//
+// Every frame's duration (start of one frame to the start of the next) is
+// kept in a fixed-size rolling window from which p50/p95/p99/max are read.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+class FramePacer
+{
+public:
+	enum Mode
+	{
+		PACING_UNCAPPED,
+		PACING_VSYNC,
+		PACING_FIXED
+	};
+
+	// Frame-time distribution over the rolling window, in milliseconds
+	struct Percentiles
+	{
+		double p50;
+		double p95;
+		double p99;
+		double max;
+		size_t samples;
+	};
+
+public:
+	// Apply the mode to the current context; targetFps is used by PACING_FIXED.
+	// Without presents (headless runs) the swap interval is left alone: there
+	// may be no GLFW context to set it on.
+	void Configure(Mode mode, double targetFps = 60.0, bool presents = true);
+
+	// Call once per frame after presenting. Waits out the rest of the frame
+	// in PACING_FIXED, then records the frame time.
+	void EndFrame();
+
+	Percentiles Report() const;
+
+	Mode GetMode() const { return mMode; }
+	double TargetFps() const { return mTargetFps; }
+
+	// Parse "uncapped", "vsync" or "fixed"; returns false for anything else
+	static bool ParseMode(const char* name, Mode& mode);
+	static const char* ModeName(Mode mode);
+
+	// Number of frames kept for the percentiles
+	static const size_t WINDOW_SIZE = 1000;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	void WaitUntil(Clock::time_point deadline);
+
+	Mode mMode = PACING_VSYNC;
+	double mTargetFps = 60.0;
+	Clock::duration mFramePeriod = Clock::duration::zero();
+
+	Clock::time_point mFrameStart;
+	Clock::time_point mDeadline;
+	bool mStarted = false;
+
+	std::vector<double> mFrameTimes;    // Rolling window, in milliseconds
+	size_t mNextSample = 0;
+};
@@ -0,0 +1,374 @@
+///////////////////////////////////////////////////////////////////////////////
+// glResources.cpp
+// ========
+// creation helpers for immutable buffer and texture storage
+///////////////////////////////////////////////////////////////////////////////
+
+#include "glResources.h"
+#include "glTrace.h"
+#include "gpuMemory.h"
+
+#include <algorithm>
+
+// Buffers are edited through GL_COPY_WRITE_BUFFER on the fallback path, a
+// target nothing else in the renderer keeps bound
+namespace
+{
+	const GLenum SCRATCH_BUFFER_TARGET = GL_COPY_WRITE_BUFFER;
+}
+
+bool HasDirectStateAccess()
+{
+	return GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access;
+}
+
+///////////////////////////////////////////////////
+//	CreateImmutableBuffer(GLsizeiptr, const void*, GLbitfield)
+//
+//	size: size of the store in bytes
+//	data: optional initial contents
+//	flags: glBufferStorage flags (GL_DYNAMIC_STORAGE_BIT, GL_MAP_*_BIT)
+//
+//	Create a buffer object with an immutable store
+///////////////////////////////////////////////////
+GLuint CreateImmutableBuffer(GLsizeiptr size, const void* data, GLbitfield flags)
+{
+	GLuint buffer = 0;
+
+	if (HasDirectStateAccess())
+	{
+		glCreateBuffers(1, &buffer);
+		glNamedBufferStorage(buffer, size, data, flags);
+	}
+	else
+	{
+		glGenBuffers(1, &buffer);
+		glBindBuffer(SCRATCH_BUFFER_TARGET, buffer);
+		glBufferStorage(SCRATCH_BUFFER_TARGET, size, data, flags);
+		glBindBuffer(SCRATCH_BUFFER_TARGET, 0);
+	}
+
+	GpuMemory::Track(GpuMemory::CATEGORY_BUFFER, buffer, size);
+	return buffer;
+}
+
+void UpdateBuffer(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	if (HasDirectStateAccess())
+	{
+		glNamedBufferSubData(buffer, offset, size, data);
+		return;
+	}
+
+	glBindBuffer(SCRATCH_BUFFER_TARGET, buffer);
+	glBufferSubData(SCRATCH_BUFFER_TARGET, offset, size, data);
+	glBindBuffer(SCRATCH_BUFFER_TARGET, 0);
+}
+
+void* MapBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr size, GLbitfield access)
+{
+	if (HasDirectStateAccess())
+		return glMapNamedBufferRange(buffer, offset, size, access);
+
+	glBindBuffer(SCRATCH_BUFFER_TARGET, buffer);
+	void* mapped = glMapBufferRange(SCRATCH_BUFFER_TARGET, offset, size, access);
+	glBindBuffer(SCRATCH_BUFFER_TARGET, 0);
+	return mapped;
+}
+
+void UnmapBuffer(GLuint buffer)
+{
+	if (HasDirectStateAccess())
+	{
+		glUnmapNamedBuffer(buffer);
+		return;
+	}
+
+	glBindBuffer(SCRATCH_BUFFER_TARGET, buffer);
+	glUnmapBuffer(SCRATCH_BUFFER_TARGET);
+	glBindBuffer(SCRATCH_BUFFER_TARGET, 0);
+}
+
+void DeleteBuffer(GLuint& buffer)
+{
+	if (buffer == 0)
+		return;
+
+	GpuMemory::Release(GpuMemory::CATEGORY_BUFFER, buffer);
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
+
+///////////////////////////////////////////////////
+//	CreateVertexArray()
+//
+//	Create a vertex array object. Without DSA the
+//	name only becomes a VAO once bound, so the
+//	fallback binds it once.
+///////////////////////////////////////////////////
+GLuint CreateVertexArray()
+{
+	GLuint vao = 0;
+
+	if (HasDirectStateAccess())
+		glCreateVertexArrays(1, &vao);
+	else
+	{
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+		glBindVertexArray(0);
+	}
+
+	return vao;
+}
+
+void SetVertexBuffer(GLuint vao, GLuint bindingIndex, GLuint buffer, GLintptr offset, GLsizei stride)
+{
+	if (HasDirectStateAccess())
+	{
+		glVertexArrayVertexBuffer(vao, bindingIndex, buffer, offset, stride);
+		return;
+	}
+
+	glBindVertexArray(vao);
+	glBindVertexBuffer(bindingIndex, buffer, offset, stride);
+	glBindVertexArray(0);
+}
+
+void SetVertexAttribute(GLuint vao, GLuint attribute, GLuint bindingIndex, GLint size, GLenum type, GLuint relativeOffset)
+{
+	if (HasDirectStateAccess())
+	{
+		glVertexArrayAttribFormat(vao, attribute, size, type, GL_FALSE, relativeOffset);
+		glVertexArrayAttribBinding(vao, attribute, bindingIndex);
+		glEnableVertexArrayAttrib(vao, attribute);
+		return;
+	}
+
+	glBindVertexArray(vao);
+	glVertexAttribFormat(attribute, size, type, GL_FALSE, relativeOffset);
+	glVertexAttribBinding(attribute, bindingIndex);
+	glEnableVertexAttribArray(attribute);
+	glBindVertexArray(0);
+}
+
+void SetElementBuffer(GLuint vao, GLuint buffer)
+{
+	if (HasDirectStateAccess())
+	{
+		glVertexArrayElementBuffer(vao, buffer);
+		return;
+	}
+
+	// The element binding is VAO state, so it stays with the VAO after unbinding
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+	glBindVertexArray(0);
+}
+
+///////////////////////////////////////////////////
+//	MipLevelCount(GLsizei, GLsizei)
+//
+//	Number of levels in a full mipmap chain
+///////////////////////////////////////////////////
+GLsizei MipLevelCount(GLsizei width, GLsizei height)
+{
+	GLsizei levels = 1;
+	for (GLsizei size = std::max(width, height); size > 1; size /= 2)
+		++levels;
+	return levels;
+}
+
+///////////////////////////////////////////////////
+//	CreateImmutableTexture2D(GLenum, GLsizei, GLsizei, GLsizei)
+//
+//	internalFormat: sized format (GL_RGB8, GL_RGBA8, ...)
+//	width, height: size of level 0
+//	levels: number of mipmap levels to allocate
+//
+//	Create a 2D texture with an immutable store
+///////////////////////////////////////////////////
+GLuint CreateImmutableTexture2D(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei levels)
+{
+	GLuint texture = 0;
+
+	if (HasDirectStateAccess())
+	{
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+		glTextureStorage2D(texture, levels, internalFormat, width, height);
+	}
+	else
+	{
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	GpuMemory::Track(GpuMemory::CATEGORY_TEXTURE, texture, GpuMemory::TextureBytes(internalFormat, width, height, levels));
+	return texture;
+}
+
+void UploadTexture2D(GLuint texture, GLint level, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	UploadTextureRegion2D(texture, level, 0, 0, width, height, format, type, pixels);
+}
+
+///////////////////////////////////////////////////
+//	UploadTextureRegion2D(GLuint, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, const void*)
+//
+//	Replace a rectangle of one level. With a buffer
+//	bound to GL_PIXEL_UNPACK_BUFFER, pixels is an
+//	offset into that buffer.
+///////////////////////////////////////////////////
+void UploadTextureRegion2D(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	if (HasDirectStateAccess())
+	{
+		glTextureSubImage2D(texture, level, x, y, width, height, format, type, pixels);
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, format, type, pixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool HasCompressedFormat(GLenum internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		return GLEW_EXT_texture_compression_s3tc != 0;
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void SetTextureParameter(GLuint texture, GLenum name, GLint value)
+{
+	if (HasDirectStateAccess())
+	{
+		glTextureParameteri(texture, name, value);
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, name, value);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GenerateTextureMipmap(GLuint texture)
+{
+	if (HasDirectStateAccess())
+	{
+		glGenerateTextureMipmap(texture);
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void DeleteTexture(GLuint& texture)
+{
+	if (texture == 0)
+		return;
+
+	GpuMemory::Release(GpuMemory::CATEGORY_TEXTURE, texture);
+	glDeleteTextures(1, &texture);
+	texture = 0;
+}
+
+///////////////////////////////////////////////////
+//	CreateImmutableTexture2DArray(GLenum, GLsizei, GLsizei, GLsizei, GLsizei)
+//
+//	internalFormat: sized or compressed format
+//	width, height: size of level 0 of every layer
+//	layers: number of layers
+//	levels: number of mipmap levels to allocate
+//
+//	Create a 2D array texture with an immutable
+//	store; every layer has the same chain
+///////////////////////////////////////////////////
+GLuint CreateImmutableTexture2DArray(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei layers, GLsizei levels)
+{
+	GLuint texture = 0;
+
+	if (HasDirectStateAccess())
+	{
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture);
+		glTextureStorage3D(texture, levels, internalFormat, width, height, layers);
+	}
+	else
+	{
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalFormat, width, height, layers);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	GpuMemory::Track(GpuMemory::CATEGORY_TEXTURE, texture, GpuMemory::TextureBytes(internalFormat, width, height, levels) * layers);
+	return texture;
+}
+
+///////////////////////////////////////////////////
+//	UploadTextureLayerRegion(GLuint, GLint, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, const void*)
+//
+//	Replace a rectangle of one level of one layer.
+//	With a buffer bound to GL_PIXEL_UNPACK_BUFFER,
+//	pixels is an offset into that buffer.
+///////////////////////////////////////////////////
+void UploadTextureLayerRegion(GLuint texture, GLint level, GLint x, GLint y, GLint layer, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	if (HasDirectStateAccess())
+	{
+		glTextureSubImage3D(texture, level, x, y, layer, width, height, 1, format, type, pixels);
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, layer, width, height, 1, format, type, pixels);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+///////////////////////////////////////////////////
+//	UploadCompressedTextureLayerRegion(GLuint, GLint, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei, const void*)
+//
+//	Replace a rectangle of one level of one layer of
+//	a block-compressed array with size bytes of
+//	blocks; it starts on a block edge and ends on one
+//	or on the level's edge. With a buffer bound to
+//	GL_PIXEL_UNPACK_BUFFER, data is an offset into
+//	that buffer.
+///////////////////////////////////////////////////
+void UploadCompressedTextureLayerRegion(GLuint texture, GLint level, GLint x, GLint y, GLint layer, GLsizei width, GLsizei height, GLenum internalFormat, GLsizei size, const void* data)
+{
+	if (HasDirectStateAccess())
+	{
+		glCompressedTextureSubImage3D(texture, level, x, y, layer, width, height, 1, internalFormat, size, data);
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, layer, width, height, 1, internalFormat, size, data);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void SetTextureArrayParameter(GLuint texture, GLenum name, GLint value)
+{
+	if (HasDirectStateAccess())
+	{
+		glTextureParameteri(texture, name, value);
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, name, value);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
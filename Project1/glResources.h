@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// glResources.h
+// ========
+// creation helpers for immutable buffer and texture storage
+//
+// Every allocation goes through glBufferStorage / glTexStorage2D, so the
+// driver knows a store will never be respecified. When the context offers
+// direct state access (GL 4.5 or ARB_direct_state_access) objects are
+// created and filled by name without touching any binding; on a plain 4.4
+// context the same calls fall back to bind-to-edit through a scratch
+// target, and restore that target to 0 afterwards.
+//
+// Stores created and deleted here are registered with GpuMemory.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+// True when objects can be edited by name instead of through bindings
+bool HasDirectStateAccess();
+
+// Buffers
+GLuint CreateImmutableBuffer(GLsizeiptr size, const void* data, GLbitfield flags);
+void UpdateBuffer(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);  // Needs GL_DYNAMIC_STORAGE_BIT
+void* MapBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr size, GLbitfield access);
+void UnmapBuffer(GLuint buffer);
+void DeleteBuffer(GLuint& buffer);      // Deletes and resets the name to 0
+
+// Vertex arrays, described with separate attribute formats and buffer bindings
+GLuint CreateVertexArray();
+void SetVertexBuffer(GLuint vao, GLuint bindingIndex, GLuint buffer, GLintptr offset, GLsizei stride);
+void SetVertexAttribute(GLuint vao, GLuint attribute, GLuint bindingIndex, GLint size, GLenum type, GLuint relativeOffset);
+void SetElementBuffer(GLuint vao, GLuint buffer);
+
+// 2D textures
+GLsizei MipLevelCount(GLsizei width, GLsizei height);
+GLuint CreateImmutableTexture2D(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei levels);
+void UploadTexture2D(GLuint texture, GLint level, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+void UploadTextureRegion2D(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+bool HasCompressedFormat(GLenum internalFormat);    // BC1 and BC3 need S3TC, BC7 is core
+void SetTextureParameter(GLuint texture, GLenum name, GLint value);
+void GenerateTextureMipmap(GLuint texture);
+void DeleteTexture(GLuint& texture);    // Deletes and resets the name to 0; any texture target
+
+// 2D array textures: layers of one size and format, addressed by layer index in the shader
+GLuint CreateImmutableTexture2DArray(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei layers, GLsizei levels);
+void UploadTextureLayerRegion(GLuint texture, GLint level, GLint x, GLint y, GLint layer, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+void UploadCompressedTextureLayerRegion(GLuint texture, GLint level, GLint x, GLint y, GLint layer, GLsizei width, GLsizei height, GLenum internalFormat, GLsizei size, const void* data);
+void SetTextureArrayParameter(GLuint texture, GLenum name, GLint value);
@@ -0,0 +1,430 @@
+///////////////////////////////////////////////////////////////////////////////
+// glTrace.cpp
+// ========
+// debug layer counting GL calls, binds and uploads per frame
+///////////////////////////////////////////////////////////////////////////////
+
+#define GL_TRACE_IMPLEMENTATION
+#include "glTrace.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+#if GL_TRACE_ENABLED
+
+namespace
+{
+	bool gInstalled = false;
+	GlTrace::Counters gCurrent = {};
+	GlTrace::Counters gLast = {};
+
+	// Shadow of the bindings set through the hooks
+	GLuint gProgram = 0;
+	GLuint gVertexArray = 0;
+	GLenum gActiveTexture = GL_TEXTURE0;
+	std::unordered_map<uint64_t, GLuint> gBuffers;          // target
+	std::unordered_map<uint64_t, GLuint> gIndexedBuffers;   // target, index
+	std::unordered_map<uint64_t, GLuint> gTextures;         // unit, target
+	std::unordered_map<uint64_t, GLuint> gFramebuffers;     // target
+
+	uint64_t Key(GLenum a, GLuint b = 0)
+	{
+		return ((uint64_t)a << 32) | b;
+	}
+
+	// Record a bind, and whether it left the binding unchanged
+	void CountBind(std::unordered_map<uint64_t, GLuint>& bindings, uint64_t key, GLuint object)
+	{
+		++gCurrent.binds;
+
+		auto it = bindings.find(key);
+		if (it != bindings.end() && it->second == object)
+			++gCurrent.redundantBinds;
+		else
+			bindings[key] = object;
+	}
+
+	void CountBind(GLuint& binding, GLuint object)
+	{
+		++gCurrent.binds;
+		if (binding == object)
+			++gCurrent.redundantBinds;
+		binding = object;
+	}
+
+	// Bytes per pixel of an uploaded format / type pair; 0 when not covered
+	unsigned int PixelSize(GLenum format, GLenum type)
+	{
+		unsigned int components = 0;
+		switch (format)
+		{
+		case GL_RED: components = 1; break;
+		case GL_RG: components = 2; break;
+		case GL_RGB: case GL_BGR: components = 3; break;
+		case GL_RGBA: case GL_BGRA: components = 4; break;
+		}
+
+		switch (type)
+		{
+		case GL_UNSIGNED_BYTE: return components;
+		case GL_FLOAT: return components * 4;
+		}
+		return 0;
+	}
+
+	// Texture sub-data comes from client memory, or from the bound pixel
+	// unpack buffer, which makes it a copy on the GPU
+	void CountPixelTransfer(unsigned long long bytes)
+	{
+		auto it = gBuffers.find(Key(GL_PIXEL_UNPACK_BUFFER));
+		if (it != gBuffers.end() && it->second != 0)
+			gCurrent.bytesCopied += bytes;
+		else
+			gCurrent.bytesUploaded += bytes;
+	}
+
+	// The original driver entry point of every hooked GLEW pointer
+	decltype(__glewUseProgram) gRealUseProgram = NULL;
+	decltype(__glewBindVertexArray) gRealBindVertexArray = NULL;
+	decltype(__glewBindBuffer) gRealBindBuffer = NULL;
+	decltype(__glewBindBufferBase) gRealBindBufferBase = NULL;
+	decltype(__glewBindBufferRange) gRealBindBufferRange = NULL;
+	decltype(__glewActiveTexture) gRealActiveTexture = NULL;
+	decltype(__glewBindFramebuffer) gRealBindFramebuffer = NULL;
+	decltype(__glewMultiDrawElementsIndirect) gRealMultiDrawElementsIndirect = NULL;
+	decltype(__glewDrawElementsInstancedBaseVertexBaseInstance) gRealDrawElementsInstancedBaseVertexBaseInstance = NULL;
+	decltype(__glewDrawElementsBaseVertex) gRealDrawElementsBaseVertex = NULL;
+	decltype(__glewBufferSubData) gRealBufferSubData = NULL;
+	decltype(__glewNamedBufferSubData) gRealNamedBufferSubData = NULL;
+	decltype(__glewCopyBufferSubData) gRealCopyBufferSubData = NULL;
+	decltype(__glewTextureSubImage2D) gRealTextureSubImage2D = NULL;
+	decltype(__glewTexSubImage3D) gRealTexSubImage3D = NULL;
+	decltype(__glewTextureSubImage3D) gRealTextureSubImage3D = NULL;
+	decltype(__glewCompressedTexSubImage3D) gRealCompressedTexSubImage3D = NULL;
+	decltype(__glewCompressedTextureSubImage3D) gRealCompressedTextureSubImage3D = NULL;
+	decltype(__glewUniform1i) gRealUniform1i = NULL;
+	decltype(__glewUniform1ui) gRealUniform1ui = NULL;
+	decltype(__glewUniform1f) gRealUniform1f = NULL;
+	decltype(__glewUniform2f) gRealUniform2f = NULL;
+	decltype(__glewUniform3f) gRealUniform3f = NULL;
+	decltype(__glewUniform4f) gRealUniform4f = NULL;
+	decltype(__glewUniformMatrix3fv) gRealUniformMatrix3fv = NULL;
+	decltype(__glewUniformMatrix4fv) gRealUniformMatrix4fv = NULL;
+
+	void GLAPIENTRY TraceUseProgram(GLuint program)
+	{
+		++gCurrent.calls;
+		CountBind(gProgram, program);
+		gRealUseProgram(program);
+	}
+
+	void GLAPIENTRY TraceBindVertexArray(GLuint array)
+	{
+		++gCurrent.calls;
+		CountBind(gVertexArray, array);
+		gRealBindVertexArray(array);
+	}
+
+	void GLAPIENTRY TraceBindBuffer(GLenum target, GLuint buffer)
+	{
+		++gCurrent.calls;
+		// The element buffer binding belongs to the VAO
+		CountBind(gBuffers, target == GL_ELEMENT_ARRAY_BUFFER ? Key(target, gVertexArray) : Key(target), buffer);
+		gRealBindBuffer(target, buffer);
+	}
+
+	void GLAPIENTRY TraceBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		++gCurrent.calls;
+		++gCurrent.binds;
+		// Also sets the generic binding; an indexed bind is redundant only
+		// when it repeats a whole-buffer bind
+		gBuffers[Key(target)] = buffer;
+		auto it = gIndexedBuffers.find(Key(target, index));
+		if (it != gIndexedBuffers.end() && it->second == buffer)
+			++gCurrent.redundantBinds;
+		gIndexedBuffers[Key(target, index)] = buffer;
+		gRealBindBufferBase(target, index, buffer);
+	}
+
+	void GLAPIENTRY TraceBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+	{
+		++gCurrent.calls;
+		++gCurrent.binds;
+		// Ranges move every frame; never treated as redundant
+		gBuffers[Key(target)] = buffer;
+		gIndexedBuffers.erase(Key(target, index));
+		gRealBindBufferRange(target, index, buffer, offset, size);
+	}
+
+	void GLAPIENTRY TraceActiveTexture(GLenum texture)
+	{
+		++gCurrent.calls;
+		gActiveTexture = texture;
+		gRealActiveTexture(texture);
+	}
+
+	void GLAPIENTRY TraceBindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		++gCurrent.calls;
+		if (target == GL_FRAMEBUFFER)
+		{
+			CountBind(gFramebuffers, Key(GL_DRAW_FRAMEBUFFER), framebuffer);
+			gFramebuffers[Key(GL_READ_FRAMEBUFFER)] = framebuffer;
+		}
+		else
+			CountBind(gFramebuffers, Key(target), framebuffer);
+		gRealBindFramebuffer(target, framebuffer);
+	}
+
+	void GLAPIENTRY TraceMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride)
+	{
+		++gCurrent.calls;
+		++gCurrent.drawCalls;
+		gRealMultiDrawElementsIndirect(mode, type, indirect, drawcount, stride);
+	}
+
+	void GLAPIENTRY TraceDrawElementsInstancedBaseVertexBaseInstance(GLenum mode, GLsizei count, GLenum type, const void* indices,
+		GLsizei instancecount, GLint basevertex, GLuint baseinstance)
+	{
+		++gCurrent.calls;
+		++gCurrent.drawCalls;
+		gRealDrawElementsInstancedBaseVertexBaseInstance(mode, count, type, indices, instancecount, basevertex, baseinstance);
+	}
+
+	void GLAPIENTRY TraceDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint basevertex)
+	{
+		++gCurrent.calls;
+		++gCurrent.drawCalls;
+		gRealDrawElementsBaseVertex(mode, count, type, indices, basevertex);
+	}
+
+	void GLAPIENTRY TraceBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		++gCurrent.calls;
+		gCurrent.bytesUploaded += size;
+		gRealBufferSubData(target, offset, size, data);
+	}
+
+	void GLAPIENTRY TraceNamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		++gCurrent.calls;
+		gCurrent.bytesUploaded += size;
+		gRealNamedBufferSubData(buffer, offset, size, data);
+	}
+
+	void GLAPIENTRY TraceCopyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size)
+	{
+		++gCurrent.calls;
+		gCurrent.bytesCopied += size;
+		gRealCopyBufferSubData(readTarget, writeTarget, readOffset, writeOffset, size);
+	}
+
+	void GLAPIENTRY TraceTextureSubImage2D(GLuint texture, GLint level, GLint xoffset, GLint yoffset,
+		GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+	{
+		++gCurrent.calls;
+		CountPixelTransfer((unsigned long long)width * height * PixelSize(format, type));
+		gRealTextureSubImage2D(texture, level, xoffset, yoffset, width, height, format, type, pixels);
+	}
+
+	void GLAPIENTRY TraceTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+		GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels)
+	{
+		++gCurrent.calls;
+		CountPixelTransfer((unsigned long long)width * height * depth * PixelSize(format, type));
+		gRealTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels);
+	}
+
+	void GLAPIENTRY TraceTextureSubImage3D(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+		GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels)
+	{
+		++gCurrent.calls;
+		CountPixelTransfer((unsigned long long)width * height * depth * PixelSize(format, type));
+		gRealTextureSubImage3D(texture, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels);
+	}
+
+	void GLAPIENTRY TraceCompressedTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+		GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLsizei imageSize, const void* data)
+	{
+		++gCurrent.calls;
+		CountPixelTransfer(imageSize);
+		gRealCompressedTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth, format, imageSize, data);
+	}
+
+	void GLAPIENTRY TraceCompressedTextureSubImage3D(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+		GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLsizei imageSize, const void* data)
+	{
+		++gCurrent.calls;
+		CountPixelTransfer(imageSize);
+		gRealCompressedTextureSubImage3D(texture, level, xoffset, yoffset, zoffset, width, height, depth, format, imageSize, data);
+	}
+
+	// Uniform setters only count; each forwards its arguments unchanged
+	void GLAPIENTRY TraceUniform1i(GLint location, GLint v0)
+	{
+		++gCurrent.calls; ++gCurrent.uniformUploads;
+		gRealUniform1i(location, v0);
+	}
+
+	void GLAPIENTRY TraceUniform1ui(GLint location, GLuint v0)
+	{
+		++gCurrent.calls; ++gCurrent.uniformUploads;
+		gRealUniform1ui(location, v0);
+	}
+
+	void GLAPIENTRY TraceUniform1f(GLint location, GLfloat v0)
+	{
+		++gCurrent.calls; ++gCurrent.uniformUploads;
+		gRealUniform1f(location, v0);
+	}
+
+	void GLAPIENTRY TraceUniform2f(GLint location, GLfloat v0, GLfloat v1)
+	{
+		++gCurrent.calls; ++gCurrent.uniformUploads;
+		gRealUniform2f(location, v0, v1);
+	}
+
+	void GLAPIENTRY TraceUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+	{
+		++gCurrent.calls; ++gCurrent.uniformUploads;
+		gRealUniform3f(location, v0, v1, v2);
+	}
+
+	void GLAPIENTRY TraceUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+	{
+		++gCurrent.calls; ++gCurrent.uniformUploads;
+		gRealUniform4f(location, v0, v1, v2, v3);
+	}
+
+	void GLAPIENTRY TraceUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		++gCurrent.calls; ++gCurrent.uniformUploads;
+		gRealUniformMatrix3fv(location, count, transpose, value);
+	}
+
+	void GLAPIENTRY TraceUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		++gCurrent.calls; ++gCurrent.uniformUploads;
+		gRealUniformMatrix4fv(location, count, transpose, value);
+	}
+}
+
+// Swap a GLEW pointer for its hook, keeping the original; entry points the
+// driver does not expose stay NULL and unhooked
+#define GL_TRACE_HOOK(name) \
+	if (__glew##name) { gReal##name = __glew##name; __glew##name = Trace##name; }
+
+#define GL_TRACE_UNHOOK(name) \
+	if (gReal##name) { __glew##name = gReal##name; gReal##name = NULL; }
+
+#define GL_TRACE_HOOKED_FUNCTIONS(X) \
+	X(UseProgram) X(BindVertexArray) X(BindBuffer) X(BindBufferBase) X(BindBufferRange) \
+	X(ActiveTexture) X(BindFramebuffer) \
+	X(MultiDrawElementsIndirect) X(DrawElementsInstancedBaseVertexBaseInstance) X(DrawElementsBaseVertex) \
+	X(BufferSubData) X(NamedBufferSubData) X(CopyBufferSubData) X(TextureSubImage2D) \
+	X(TexSubImage3D) X(TextureSubImage3D) X(CompressedTexSubImage3D) X(CompressedTextureSubImage3D) \
+	X(Uniform1i) X(Uniform1ui) X(Uniform1f) X(Uniform2f) X(Uniform3f) X(Uniform4f) \
+	X(UniformMatrix3fv) X(UniformMatrix4fv)
+
+///////////////////////////////////////////////////
+//	Install()
+//
+//	Route the hooked entry points through the
+//	counters. The shadowed bindings start from the
+//	default state, so install before any binds.
+///////////////////////////////////////////////////
+bool GlTrace::Install()
+{
+	if (gInstalled)
+		return true;
+
+	GL_TRACE_HOOKED_FUNCTIONS(GL_TRACE_HOOK)
+
+	gCurrent = Counters();
+	gLast = Counters();
+	gInstalled = true;
+	return true;
+}
+
+void GlTrace::Uninstall()
+{
+	if (!gInstalled)
+		return;
+
+	GL_TRACE_HOOKED_FUNCTIONS(GL_TRACE_UNHOOK)
+
+	gInstalled = false;
+}
+
+bool GlTrace::IsInstalled()
+{
+	return gInstalled;
+}
+
+void GlTrace::EndFrame()
+{
+	gLast = gCurrent;
+	gCurrent = Counters();
+}
+
+const GlTrace::Counters& GlTrace::LastFrame()
+{
+	return gLast;
+}
+
+void GLAPIENTRY GlTrace::BindTexture(GLenum target, GLuint texture)
+{
+	if (gInstalled)
+	{
+		++gCurrent.calls;
+		CountBind(gTextures, Key(gActiveTexture, target), texture);
+	}
+	glBindTexture(target, texture);
+}
+
+void GLAPIENTRY GlTrace::DrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	if (gInstalled)
+	{
+		++gCurrent.calls;
+		++gCurrent.drawCalls;
+	}
+	glDrawArrays(mode, first, count);
+}
+
+void GLAPIENTRY GlTrace::DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	if (gInstalled)
+	{
+		++gCurrent.calls;
+		++gCurrent.drawCalls;
+	}
+	glDrawElements(mode, count, type, indices);
+}
+
+void GLAPIENTRY GlTrace::TexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset,
+	GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	if (gInstalled)
+	{
+		++gCurrent.calls;
+		CountPixelTransfer((unsigned long long)width * height * PixelSize(format, type));
+	}
+	glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+}
+
+#else
+
+namespace
+{
+	const GlTrace::Counters gNone = {};
+}
+
+bool GlTrace::Install() { return false; }
+void GlTrace::Uninstall() {}
+bool GlTrace::IsInstalled() { return false; }
+void GlTrace::EndFrame() {}
+const GlTrace::Counters& GlTrace::LastFrame() { return gNone; }
+
+#endif
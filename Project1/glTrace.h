@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// glTrace.h
+// ========
+// debug layer counting GL calls, binds and uploads per frame
+//
+// Install() swaps the GLEW function pointers of the entry points the
+// renderer uses for counting wrappers that forward to the driver. GL 1.1
+// functions (glBindTexture, glDrawArrays, glDrawElements, glTexSubImage2D)
+// are not GLEW pointers, so including this header after glew.h redirects
+// them by macro instead; those wrappers only count while the layer is
+// installed.
+//
+// A bind is redundant when it sets the binding point to the object it
+// already holds. Bindings are shadowed on the CPU from the calls seen
+// here, so objects deleted while bound can leave stale entries.
+//
+// Build with GL_TRACE_ENABLED=0 to compile the layer and its macros out.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#ifndef GL_TRACE_ENABLED
+#define GL_TRACE_ENABLED 1
+#endif
+
+namespace GlTrace
+{
+	// Totals for one frame
+	struct Counters
+	{
+		unsigned int calls;                 // Every intercepted call
+		unsigned int drawCalls;             // Draws and multi-draws, each counted once
+		unsigned int uniformUploads;        // glUniform* calls
+		unsigned int binds;                 // Program, VAO, buffer, texture and framebuffer binds
+		unsigned int redundantBinds;        // Binds that changed nothing
+		unsigned long long bytesUploaded;   // Buffer and texture sub-data from client memory
+		unsigned long long bytesCopied;     // Copies on the GPU: buffer to buffer, and texture sub-data from a pixel unpack buffer
+	};
+
+	// Hook the GLEW pointers; needs glewInit() first
+	bool Install();
+	void Uninstall();
+	bool IsInstalled();
+
+	// Close the current frame: its counters become LastFrame()
+	void EndFrame();
+	const Counters& LastFrame();
+
+#if GL_TRACE_ENABLED
+	// Wrappers for the GL 1.1 entry points, used through the macros below
+	void GLAPIENTRY BindTexture(GLenum target, GLuint texture);
+	void GLAPIENTRY DrawArrays(GLenum mode, GLint first, GLsizei count);
+	void GLAPIENTRY DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+	void GLAPIENTRY TexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset,
+		GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+#endif
+}
+
+#if GL_TRACE_ENABLED && !defined(GL_TRACE_IMPLEMENTATION)
+#define glBindTexture GlTrace::BindTexture
+#define glDrawArrays GlTrace::DrawArrays
+#define glDrawElements GlTrace::DrawElements
+#define glTexSubImage2D GlTrace::TexSubImage2D
+#endif
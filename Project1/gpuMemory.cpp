@@ -0,0 +1,220 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuMemory.cpp
+// ========
+// registry of the video memory held by every GL resource, per category
+///////////////////////////////////////////////////////////////////////////////
+
+#include "gpuMemory.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+
+namespace
+{
+	struct CategoryState
+	{
+		GpuMemory::Stats stats;
+		std::unordered_map<GLuint, size_t> sizes;   // Live resources by GL name
+	};
+
+	// GL objects only live on the context's thread, so no locking is needed
+	CategoryState gCategories[GpuMemory::CATEGORY_COUNT];
+
+	size_t gBudget = 0;
+	size_t gTotalLive = 0;
+	size_t gTotalPeak = 0;
+	bool gBudgetWarned = false;
+
+	const char* CATEGORY_NAMES[GpuMemory::CATEGORY_COUNT] = { "buffers", "textures", "renderbuffers", "programs" };
+
+	double Megabytes(size_t bytes)
+	{
+		return bytes / (1024.0 * 1024.0);
+	}
+
+	// Bytes per 4x4 block of the compressed formats, 0 for any other
+	size_t BytesPerBlock(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+			return 8;
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	// Bytes per texel of the uncompressed formats the renderer allocates
+	size_t BytesPerTexel(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_R8:
+			return 1;
+		case GL_RG8:
+		case GL_R16F:
+		case GL_DEPTH_COMPONENT16:
+			return 2;
+		case GL_RGBA16F:
+			return 8;
+		case GL_RGBA32F:
+			return 16;
+		default:
+			// GL_RGBA8, GL_SRGB8_ALPHA8, depth 24/32; drivers also keep GL_RGB8 padded to four bytes
+			return 4;
+		}
+	}
+}
+
+namespace GpuMemory
+{
+	///////////////////////////////////////////////////
+	//	Track(Category, GLuint, size_t)
+	//
+	//	category: kind of resource
+	//	name: GL name of the resource
+	//	bytes: size of its store
+	//
+	//	Register a resource and update the live and
+	//	peak counters
+	///////////////////////////////////////////////////
+	void Track(Category category, GLuint name, size_t bytes)
+	{
+		if (name == 0)
+			return;
+
+		Release(category, name);
+
+		CategoryState& state = gCategories[category];
+		state.sizes[name] = bytes;
+		state.stats.liveBytes += bytes;
+		state.stats.peakBytes = std::max(state.stats.peakBytes, state.stats.liveBytes);
+		++state.stats.liveCount;
+		++state.stats.allocations;
+
+		gTotalLive += bytes;
+		gTotalPeak = std::max(gTotalPeak, gTotalLive);
+
+		if (gBudget != 0 && gTotalLive > gBudget && !gBudgetWarned)
+		{
+			std::cout << "WARNING: GPU memory over budget: " << std::fixed << std::setprecision(2) << Megabytes(gTotalLive)
+				<< " MB live, budget " << Megabytes(gBudget) << " MB (" << CATEGORY_NAMES[category] << " allocation of "
+				<< bytes << " bytes)" << std::defaultfloat << std::endl;
+			gBudgetWarned = true;
+		}
+	}
+
+	void Release(Category category, GLuint name)
+	{
+		CategoryState& state = gCategories[category];
+
+		auto found = state.sizes.find(name);
+		if (found == state.sizes.end())
+			return;
+
+		state.stats.liveBytes -= found->second;
+		--state.stats.liveCount;
+		gTotalLive -= found->second;
+
+		state.sizes.erase(found);
+	}
+
+	Stats Query(Category category)
+	{
+		return gCategories[category].stats;
+	}
+
+	Stats Total()
+	{
+		Stats total;
+		for (const CategoryState& state : gCategories)
+		{
+			total.liveBytes += state.stats.liveBytes;
+			total.liveCount += state.stats.liveCount;
+			total.allocations += state.stats.allocations;
+		}
+
+		// The categories peak at different times; the total has its own peak
+		total.peakBytes = gTotalPeak;
+		return total;
+	}
+
+	void SetBudget(size_t bytes)
+	{
+		gBudget = bytes;
+		gBudgetWarned = false;
+	}
+
+	bool OverBudget()
+	{
+		return gBudget != 0 && gTotalPeak > gBudget;
+	}
+
+	size_t TextureBytes(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei levels)
+	{
+		size_t bytes = 0;
+		for (GLsizei level = 0; level < levels; ++level)
+		{
+			size_t levelWidth = std::max(1, width >> level);
+			size_t levelHeight = std::max(1, height >> level);
+			if (size_t blockBytes = BytesPerBlock(internalFormat))
+				bytes += (levelWidth + 3) / 4 * ((levelHeight + 3) / 4) * blockBytes;
+			else
+				bytes += levelWidth * levelHeight * BytesPerTexel(internalFormat);
+		}
+		return bytes;
+	}
+
+	///////////////////////////////////////////////////
+	//	Report()
+	//
+	//	Print the counters of every category; anything
+	//	still live is reported as leaked, name by name.
+	//	Meant for the end of the run.
+	///////////////////////////////////////////////////
+	void Report()
+	{
+		std::cout << "GPU memory:" << std::fixed << std::setprecision(2) << std::endl;
+		for (int i = 0; i < CATEGORY_COUNT; ++i)
+		{
+			const Stats& stats = gCategories[i].stats;
+			std::cout << "  " << std::left << std::setw(14) << CATEGORY_NAMES[i] << std::right
+				<< " live " << std::setw(8) << Megabytes(stats.liveBytes) << " MB"
+				<< "  peak " << std::setw(8) << Megabytes(stats.peakBytes) << " MB"
+				<< "  allocations " << stats.allocations << std::endl;
+		}
+
+		Stats total = Total();
+		std::cout << "  " << std::left << std::setw(14) << "total" << std::right
+			<< " live " << std::setw(8) << Megabytes(total.liveBytes) << " MB"
+			<< "  peak " << std::setw(8) << Megabytes(total.peakBytes) << " MB";
+		if (gBudget != 0)
+			std::cout << "  budget " << Megabytes(gBudget) << " MB";
+		std::cout << std::defaultfloat << std::endl;
+
+		// Called once everything has been destroyed, so whatever is live has leaked
+		for (int i = 0; i < CATEGORY_COUNT; ++i)
+		{
+			const CategoryState& state = gCategories[i];
+			if (state.sizes.empty())
+				continue;
+
+			std::cout << "WARNING: " << state.stats.liveCount << " " << CATEGORY_NAMES[i] << " leaked, "
+				<< state.stats.liveBytes << " bytes:";
+			for (const auto& resource : state.sizes)
+				std::cout << " " << resource.first << " (" << resource.second << ")";
+			std::cout << std::endl;
+		}
+	}
+
+	const char* CategoryName(Category category)
+	{
+		return CATEGORY_NAMES[category];
+	}
+}
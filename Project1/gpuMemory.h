@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuMemory.h
+// ========
+// registry of the video memory held by every GL resource, per category
+//
+// Every buffer, texture, renderbuffer and program is registered with its
+// byte size when its store is allocated, and released when it is deleted.
+// The registry keeps live and peak bytes per category, can be queried at
+// any time, and reports whatever is still registered at exit as leaked.
+//
+// Sizes are those the resources request (a texture counts its whole mip
+// chain, a program its binary); drivers may add alignment on top.
+// A budget, when set, is checked on every allocation.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+namespace GpuMemory
+{
+	enum Category
+	{
+		CATEGORY_BUFFER,
+		CATEGORY_TEXTURE,
+		CATEGORY_RENDERBUFFER,
+		CATEGORY_PROGRAM,
+		CATEGORY_COUNT
+	};
+
+	struct Stats
+	{
+		size_t liveBytes = 0;
+		size_t peakBytes = 0;
+		size_t liveCount = 0;       // Resources currently registered
+		size_t allocations = 0;     // Resources ever registered
+	};
+
+	// Register a resource's store; registering a name again replaces its size
+	void Track(Category category, GLuint name, size_t bytes);
+
+	// Forget a deleted resource; unknown names are ignored
+	void Release(Category category, GLuint name);
+
+	// Counters of one category, or summed over all of them
+	Stats Query(Category category);
+	Stats Total();
+
+	// Bytes all categories together may hold; 0 disables the check
+	void SetBudget(size_t bytes);
+	bool OverBudget();          // True once the peak has exceeded the budget
+
+	// Bytes of a texture store: width x height at level 0, with levels mips
+	size_t TextureBytes(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei levels);
+
+	// Print live, peak and leaked bytes per category and list leaked names
+	void Report();
+
+	const char* CategoryName(Category category);
+}
@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuProfiler.cpp
+// ========
+// GPU time per named scope, measured with GL_TIMESTAMP queries
+///////////////////////////////////////////////////////////////////////////////
+
+#include "gpuProfiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+///////////////////////////////////////////////////
+//	Create()
+//
+//	Allocate the query objects for every frame slot
+///////////////////////////////////////////////////
+void GpuProfiler::Create()
+{
+	mQueries.resize(LATENCY_FRAMES * MAX_SCOPES_PER_FRAME * 2);
+	glGenQueries((GLsizei)mQueries.size(), mQueries.data());
+
+	for (FrameSlot& slot : mSlots)
+	{
+		slot.records.clear();
+		slot.usedQueries = 0;
+		slot.lastIssued = -1;
+	}
+	mCurrentSlot = 0;
+}
+
+void GpuProfiler::Destroy()
+{
+	if (!mQueries.empty())
+		glDeleteQueries((GLsizei)mQueries.size(), mQueries.data());
+
+	mQueries.clear();
+}
+
+///////////////////////////////////////////////////
+//	BeginFrame()
+//
+//	Advance to the next slot and read back the
+//	results it holds from LATENCY_FRAMES frames ago
+///////////////////////////////////////////////////
+void GpuProfiler::BeginFrame()
+{
+	if (!IsCreated())
+		return;
+
+	mCurrentSlot = (mCurrentSlot + 1) % LATENCY_FRAMES;
+
+	FrameSlot& slot = mSlots[mCurrentSlot];
+	Collect(slot, mCurrentSlot);
+
+	slot.records.clear();
+	slot.usedQueries = 0;
+	slot.lastIssued = -1;
+	mOpenScopes.clear();
+	mInFrame = true;
+}
+
+void GpuProfiler::EndFrame()
+{
+	// Unbalanced scopes would pair with the wrong timestamps; close them
+	while (!mOpenScopes.empty())
+		EndScope();
+
+	mInFrame = false;
+}
+
+///////////////////////////////////////////////////
+//	BeginScope(const char*)
+//
+//	name: label of the scope
+//
+//	Write the start timestamp of a scope
+///////////////////////////////////////////////////
+void GpuProfiler::BeginScope(const char* name)
+{
+	if (!mInFrame)
+		return;
+
+	FrameSlot& slot = mSlots[mCurrentSlot];
+
+	// Out of queries for this frame: the scope simply goes unmeasured
+	if (slot.usedQueries + 2 > MAX_SCOPES_PER_FRAME * 2)
+	{
+		mOpenScopes.push_back(-1);
+		return;
+	}
+
+	ScopeRecord record;
+	record.scope = FindScope(name);
+	record.startQuery = slot.usedQueries++;
+	record.endQuery = slot.usedQueries++;
+
+	glQueryCounter(Query(mCurrentSlot, record.startQuery), GL_TIMESTAMP);
+	slot.lastIssued = record.startQuery;
+
+	mOpenScopes.push_back((int)slot.records.size());
+	slot.records.push_back(record);
+}
+
+void GpuProfiler::EndScope()
+{
+	if (mOpenScopes.empty())
+		return;
+
+	int recordIndex = mOpenScopes.back();
+	mOpenScopes.pop_back();
+	if (recordIndex < 0)
+		return;
+
+	FrameSlot& slot = mSlots[mCurrentSlot];
+	const ScopeRecord& record = slot.records[recordIndex];
+	glQueryCounter(Query(mCurrentSlot, record.endQuery), GL_TIMESTAMP);
+	slot.lastIssued = record.endQuery;
+}
+
+///////////////////////////////////////////////////
+//	ExportCsv(const char*)
+//
+//	path: file to write
+//
+//	Write the statistics of every scope as CSV
+///////////////////////////////////////////////////
+bool GpuProfiler::ExportCsv(const char* path) const
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cout << "ERROR::GPU_PROFILER::CANNOT_WRITE " << path << std::endl;
+		return false;
+	}
+
+	file << "scope,samples,avg_ms,min_ms,max_ms,last_ms\n";
+	for (const ScopeStats& stats : mScopes)
+	{
+		file << stats.name << ',' << stats.samples << ',' << stats.average << ','
+			<< stats.min << ',' << stats.max << ',' << stats.last << '\n';
+	}
+
+	return true;
+}
+
+const GpuProfiler::ScopeStats* GpuProfiler::Find(const char* name) const
+{
+	auto it = mScopeIndices.find(name);
+	return it != mScopeIndices.end() ? &mScopes[it->second] : NULL;
+}
+
+void GpuProfiler::ResetStats()
+{
+	for (ScopeStats& stats : mScopes)
+	{
+		stats.samples = 0;
+		stats.last = stats.average = stats.min = stats.max = 0.0;
+		stats.window.clear();
+		stats.nextSample = 0;
+		stats.windowSum = 0.0;
+	}
+}
+
+int GpuProfiler::FindScope(const char* name)
+{
+	auto it = mScopeIndices.find(name);
+	if (it != mScopeIndices.end())
+		return it->second;
+
+	ScopeStats stats;
+	stats.name = name;
+	stats.window.reserve(AVERAGE_WINDOW);
+
+	int index = (int)mScopes.size();
+	mScopes.push_back(stats);
+	mScopeIndices[name] = index;
+	return index;
+}
+
+///////////////////////////////////////////////////
+//	Collect(FrameSlot&, int)
+//
+//	Read the timestamps of a finished slot. The
+//	slot is only read if the last timestamp issued
+//	into it has landed, which implies every earlier
+//	one has too. That is the outermost scope's end,
+//	not the highest query index.
+///////////////////////////////////////////////////
+void GpuProfiler::Collect(FrameSlot& slot, int slotIndex)
+{
+	if (slot.lastIssued < 0)
+		return;
+
+	GLint available = 0;
+	glGetQueryObjectiv(Query(slotIndex, slot.lastIssued), GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+
+	for (const ScopeRecord& record : slot.records)
+	{
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(Query(slotIndex, record.startQuery), GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(Query(slotIndex, record.endQuery), GL_QUERY_RESULT, &end);
+
+		if (end >= start)
+			AddSample(mScopes[record.scope], (end - start) / 1.0e6);
+	}
+}
+
+void GpuProfiler::AddSample(ScopeStats& stats, double milliseconds)
+{
+	if (stats.samples == 0)
+		stats.min = stats.max = milliseconds;
+	else
+	{
+		stats.min = std::min(stats.min, milliseconds);
+		stats.max = std::max(stats.max, milliseconds);
+	}
+
+	++stats.samples;
+	stats.last = milliseconds;
+
+	if (stats.window.size() < AVERAGE_WINDOW)
+		stats.window.push_back(milliseconds);
+	else
+	{
+		stats.windowSum -= stats.window[stats.nextSample];
+		stats.window[stats.nextSample] = milliseconds;
+	}
+	stats.nextSample = (stats.nextSample + 1) % AVERAGE_WINDOW;
+	stats.windowSum += milliseconds;
+
+	stats.average = stats.windowSum / stats.window.size();
+}
@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuProfiler.h
+// ========
+// GPU time per named scope, measured with GL_TIMESTAMP queries
+//
+// Each scope writes a timestamp query at its start and end. Queries live
+// in a ring of LATENCY_FRAMES frame slots; a slot's results are read just
+// before the slot is reused, LATENCY_FRAMES frames later, when the GPU has
+// long finished with them. Results that are still not available are
+// dropped rather than waited for, so reading never stalls the pipeline.
+//
+// Durations are averaged over the last AVERAGE_WINDOW samples of each
+// scope and can be exported to CSV.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class GpuProfiler
+{
+public:
+	// Statistics of one scope, in milliseconds
+	struct ScopeStats
+	{
+		std::string name;
+		unsigned long long samples = 0;     // Frames measured since Create()
+		double last = 0.0;
+		double average = 0.0;               // Over the last AVERAGE_WINDOW samples
+		double min = 0.0;
+		double max = 0.0;
+
+		std::vector<double> window;         // Most recent samples, rolling
+		size_t nextSample = 0;
+		double windowSum = 0.0;
+	};
+
+	static const int LATENCY_FRAMES = 4;
+	static const int MAX_SCOPES_PER_FRAME = 64;
+	static const size_t AVERAGE_WINDOW = 120;
+
+public:
+	void Create();
+	void Destroy();
+
+	// Collect the slot about to be reused, then start recording into it
+	void BeginFrame();
+	void EndFrame();
+
+	// Scopes may nest; the name must outlive the frame
+	void BeginScope(const char* name);
+	void EndScope();
+
+	bool IsCreated() const { return !mQueries.empty(); }
+
+	// Every scope seen so far, in order of first appearance
+	const std::vector<ScopeStats>& Scopes() const { return mScopes; }
+	const ScopeStats* Find(const char* name) const;
+
+	// Forget all samples, e.g. between benchmark runs; scope names are kept
+	void ResetStats();
+
+	// One row per scope: scope,samples,avg_ms,min_ms,max_ms,last_ms
+	bool ExportCsv(const char* path) const;
+
+private:
+	struct ScopeRecord
+	{
+		int scope;          // Index into mScopes
+		int startQuery;     // Index into the slot's queries
+		int endQuery;
+	};
+
+	struct FrameSlot
+	{
+		std::vector<ScopeRecord> records;
+		int usedQueries = 0;
+		int lastIssued = -1;    // Query of the latest glQueryCounter; nested scopes end out of index order
+	};
+
+	int FindScope(const char* name);
+	void Collect(FrameSlot& slot, int slotIndex);
+	void AddSample(ScopeStats& stats, double milliseconds);
+
+	GLuint Query(int slot, int index) const { return mQueries[slot * MAX_SCOPES_PER_FRAME * 2 + index]; }
+
+	std::vector<GLuint> mQueries;
+	FrameSlot mSlots[LATENCY_FRAMES];
+	int mCurrentSlot = 0;
+	bool mInFrame = false;
+
+	std::vector<int> mOpenScopes;       // Stack of records in the current slot
+
+	std::vector<ScopeStats> mScopes;
+	std::unordered_map<std::string, int> mScopeIndices;
+};
+
+// Times the enclosing C++ scope on the GPU
+class GpuScope
+{
+public:
+	GpuScope(GpuProfiler& profiler, const char* name) : mProfiler(profiler) { mProfiler.BeginScope(name); }
+	~GpuScope() { mProfiler.EndScope(); }
+
+	GpuScope(const GpuScope&) = delete;
+	GpuScope& operator=(const GpuScope&) = delete;
+
+private:
+	GpuProfiler& mProfiler;
+};
@@ -0,0 +1,176 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlessContext.cpp
+// ========
+// OpenGL context without a window, for machines with no display
+///////////////////////////////////////////////////////////////////////////////
+
+#include "headlessContext.h"
+
+#include <iostream>
+
+#if HEADLESS_EGL
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace
+{
+	EGLDisplay gDisplay = EGL_NO_DISPLAY;
+	EGLContext gContext = EGL_NO_CONTEXT;
+
+	// Prefer the surfaceless platform, which needs no window system at all
+	EGLDisplay OpenDisplay()
+	{
+#if defined(EGL_EXT_platform_base) && defined(EGL_PLATFORM_SURFACELESS_MESA)
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay)
+		{
+			EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+			if (display != EGL_NO_DISPLAY)
+				return display;
+		}
+#endif
+		return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+}
+
+///////////////////////////////////////////////////
+//	CreateHeadlessContext()
+//
+//	Open an EGL display, bind desktop OpenGL and
+//	make a 4.4 core context current without any
+//	surface (EGL_KHR_surfaceless_context)
+///////////////////////////////////////////////////
+bool CreateHeadlessContext()
+{
+	gDisplay = OpenDisplay();
+	if (gDisplay == EGL_NO_DISPLAY || !eglInitialize(gDisplay, NULL, NULL))
+	{
+		std::cout << "ERROR::HEADLESS::EGL_DISPLAY_UNAVAILABLE" << std::endl;
+		return false;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cout << "ERROR::HEADLESS::OPENGL_API_UNSUPPORTED" << std::endl;
+		return false;
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(gDisplay, configAttributes, &config, 1, &configCount) || configCount == 0)
+	{
+		std::cout << "ERROR::HEADLESS::NO_EGL_CONFIG" << std::endl;
+		return false;
+	}
+
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 4,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	gContext = eglCreateContext(gDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+	if (gContext == EGL_NO_CONTEXT)
+	{
+		std::cout << "ERROR::HEADLESS::CONTEXT_CREATION_FAILED" << std::endl;
+		return false;
+	}
+
+	if (!eglMakeCurrent(gDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, gContext))
+	{
+		std::cout << "ERROR::HEADLESS::SURFACELESS_CONTEXT_UNSUPPORTED" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void DestroyHeadlessContext()
+{
+	if (gDisplay == EGL_NO_DISPLAY)
+		return;
+
+	eglMakeCurrent(gDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (gContext != EGL_NO_CONTEXT)
+		eglDestroyContext(gDisplay, gContext);
+	eglTerminate(gDisplay);
+
+	gContext = EGL_NO_CONTEXT;
+	gDisplay = EGL_NO_DISPLAY;
+}
+
+const char* HeadlessBackendName()
+{
+	return "EGL";
+}
+
+#else
+
+#include <GLFW/glfw3.h>
+
+namespace
+{
+	GLFWwindow* gHiddenWindow = nullptr;
+}
+
+///////////////////////////////////////////////////
+//	CreateHeadlessContext()
+//
+//	Create a hidden GLFW window and make its
+//	context current. Its default framebuffer is
+//	never drawn to.
+///////////////////////////////////////////////////
+bool CreateHeadlessContext()
+{
+	// GLFW 3.4: no display connection at all. Windows always has a desktop to
+	// hide the window on, and OSMesa is rarely there to back the null platform.
+#if defined(GLFW_PLATFORM_NULL) && !defined(_WIN32)
+	glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+	if (!glfwInit())
+	{
+		std::cout << "ERROR::HEADLESS::GLFW_INIT_FAILED" << std::endl;
+		return false;
+	}
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#if defined(GLFW_PLATFORM_NULL) && defined(GLFW_OSMESA_CONTEXT_API) && !defined(_WIN32)
+	glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
+
+	gHiddenWindow = glfwCreateWindow(1, 1, "headless", NULL, NULL);
+	if (gHiddenWindow == NULL)
+	{
+		std::cout << "ERROR::HEADLESS::CONTEXT_CREATION_FAILED" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+
+	glfwMakeContextCurrent(gHiddenWindow);
+	return true;
+}
+
+void DestroyHeadlessContext()
+{
+	if (gHiddenWindow)
+		glfwDestroyWindow(gHiddenWindow);
+	gHiddenWindow = nullptr;
+
+	glfwTerminate();
+}
+
+const char* HeadlessBackendName()
+{
+	return "GLFW";
+}
+
+#endif
@@ -0,0 +1,33 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlessContext.h
+// ========
+// OpenGL context without a window, for machines with no display
+//
+// Two backends, picked by HEADLESS_EGL:
+//	GLFW	the default. Creates a hidden window, which on Windows needs a
+//			desktop session. Elsewhere, with GLFW 3.4, it selects the null
+//			platform and an OSMesa context, which needs neither a display
+//			server nor a GPU (Mesa llvmpipe).
+//	EGL		opt in with HEADLESS_EGL=1 and link against libEGL. Uses the
+//			Mesa surfaceless platform when available, else the default EGL
+//			display, and makes the context current with no surface at all.
+//			GLEW must be built with GLEW_EGL so glewInit() resolves entry
+//			points through EGL; a stock GLEW looks for a GLX display and
+//			fails with GLEW_ERROR_NO_GLX_DISPLAY.
+//
+// Either way nothing is ever presented: the caller renders into an
+// OffscreenTarget (see offscreenTarget.h).
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifndef HEADLESS_EGL
+#define HEADLESS_EGL 0
+#endif
+
+// Create a 4.4 core context and make it current on the calling thread
+bool CreateHeadlessContext();
+void DestroyHeadlessContext();
+
+// "EGL" or "GLFW", for log output
+const char* HeadlessBackendName();
@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// imageUtils.cpp
+// ========
+// CPU-side helpers for decoded image data
+///////////////////////////////////////////////////////////////////////////////
+
+#include "imageUtils.h"
+
+#include <algorithm>
+#include <cstdint>
+
+// Images are loaded with Y axis going down, but OpenGL's Y axis goes up, so let's flip it //
+void flipImageVertically(unsigned char* image, int width, int height, int channels)
+{
+	for (int j = 0; j < height / 2; ++j)
+	{
+		int index1 = j * width * channels;
+		int index2 = (height - 1 - j) * width * channels;
+
+		for (int i = width * channels; i > 0; --i)
+		{
+			unsigned char tmp = image[index1];
+			image[index1] = image[index2];
+			image[index2] = tmp;
+			++index1;
+			++index2;
+		}
+	}
+}
+
+// Box-filter an image down to its next mip level //
+void downsampleImage(const unsigned char* image, int width, int height, int channels, unsigned char* half)
+{
+	int halfWidth = std::max(1, width / 2);
+	int halfHeight = std::max(1, height / 2);
+
+	for (int y = 0; y < halfHeight; ++y)
+	{
+		const unsigned char* row0 = image + (size_t)std::min(2 * y, height - 1) * width * channels;
+		const unsigned char* row1 = image + (size_t)std::min(2 * y + 1, height - 1) * width * channels;
+		for (int x = 0; x < halfWidth; ++x)
+		{
+			int x0 = std::min(2 * x, width - 1) * channels;
+			int x1 = std::min(2 * x + 1, width - 1) * channels;
+			for (int c = 0; c < channels; ++c)
+			{
+				int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+				half[((size_t)y * halfWidth + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+// Area-average an image to any size //
+void resampleImage(const unsigned char* image, int width, int height, int channels,
+	unsigned char* scaled, int scaledWidth, int scaledHeight)
+{
+	uint32_t sum[4];
+	for (int y = 0; y < scaledHeight; ++y)
+	{
+		// Source rows under this texel, at least one
+		int y0 = (int)((int64_t)y * height / scaledHeight);
+		int y1 = std::max(y0 + 1, (int)((int64_t)(y + 1) * height / scaledHeight));
+		for (int x = 0; x < scaledWidth; ++x)
+		{
+			int x0 = (int)((int64_t)x * width / scaledWidth);
+			int x1 = std::max(x0 + 1, (int)((int64_t)(x + 1) * width / scaledWidth));
+
+			std::fill(sum, sum + channels, 0u);
+			for (int sourceY = y0; sourceY < y1; ++sourceY)
+			{
+				const unsigned char* texel = image + ((size_t)sourceY * width + x0) * channels;
+				for (int sourceX = x0; sourceX < x1; ++sourceX)
+					for (int c = 0; c < channels; ++c)
+						sum[c] += *texel++;
+			}
+
+			uint32_t count = (uint32_t)((y1 - y0) * (x1 - x0));
+			for (int c = 0; c < channels; ++c)
+				scaled[((size_t)y * scaledWidth + x) * channels + c] = (unsigned char)((sum[c] + count / 2) / count);
+		}
+	}
+}
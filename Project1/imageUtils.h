@@ -0,0 +1,19 @@
+///////////////////////////////////////////////////////////////////////////////
+// imageUtils.h
+// ========
+// CPU-side helpers for decoded image data
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// Images are loaded with Y axis going down, but OpenGL's Y axis goes up, so flip the rows in place
+void flipImageVertically(unsigned char* image, int width, int height, int channels);
+
+// Next mip level of an image into half, max(1, width / 2) x max(1, height / 2): every texel
+// averages a 2x2 square, with the last row or column repeated for odd sizes
+void downsampleImage(const unsigned char* image, int width, int height, int channels, unsigned char* half);
+
+// Scale an image to scaledWidth x scaledHeight into scaled: every texel averages the source
+// texels under it, so any reduction is filtered; enlarging repeats the nearest texel
+void resampleImage(const unsigned char* image, int width, int height, int channels,
+	unsigned char* scaled, int scaledWidth, int scaledHeight);
@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////
+// inputLog.cpp
+// ========
+// compact binary log of per-frame input, for recording and replaying runs
+///////////////////////////////////////////////////////////////////////////////
+
+#include "inputLog.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	const char MAGIC[4] = { 'I', 'N', 'P', 'L' };
+	const uint32_t VERSION = 1;
+
+	// A frame cannot plausibly hold more events than this; guards corrupt logs
+	const uint32_t MAX_EVENTS_PER_FRAME = 1u << 16;
+
+	template <typename T>
+	bool Write(FILE* file, const T& value)
+	{
+		return fwrite(&value, sizeof(T), 1, file) == 1;
+	}
+
+	template <typename T>
+	bool Read(FILE* file, T& value)
+	{
+		return fread(&value, sizeof(T), 1, file) == 1;
+	}
+}
+
+///////////////////////////////////////////////////
+//	OpenForRecording(const char*)
+//
+//	path: log file to create
+//
+//	Create the log and write its header
+///////////////////////////////////////////////////
+bool InputLog::OpenForRecording(const char* path)
+{
+	Close();
+
+	mFile = fopen(path, "wb");
+	if (!mFile)
+	{
+		std::cout << "ERROR::INPUT_LOG::CANNOT_WRITE " << path << std::endl;
+		return false;
+	}
+
+	mRecording = true;
+	mFrameCount = 0;
+
+	fwrite(MAGIC, 1, sizeof(MAGIC), mFile);
+	Write(mFile, VERSION);
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	OpenForReplay(const char*)
+//
+//	path: log file written by a recording run
+//
+//	Open the log and check its header
+///////////////////////////////////////////////////
+bool InputLog::OpenForReplay(const char* path)
+{
+	Close();
+
+	mFile = fopen(path, "rb");
+	if (!mFile)
+	{
+		std::cout << "ERROR::INPUT_LOG::CANNOT_READ " << path << std::endl;
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	if (fread(magic, 1, sizeof(magic), mFile) != sizeof(magic) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+		!Read(mFile, version) || version != VERSION)
+	{
+		std::cout << "ERROR::INPUT_LOG::NOT_AN_INPUT_LOG " << path << std::endl;
+		Close();
+		return false;
+	}
+
+	mRecording = false;
+	mFrameCount = 0;
+	return true;
+}
+
+void InputLog::Close()
+{
+	if (mFile)
+		fclose(mFile);
+
+	mFile = NULL;
+}
+
+bool InputLog::WriteFrame(const Frame& frame)
+{
+	if (!IsRecording())
+		return false;
+
+	bool written = Write(mFile, frame.deltaTime) && Write(mFile, frame.keys) && Write(mFile, (uint32_t)frame.events.size());
+	for (const Event& event : frame.events)
+		written = written && Write(mFile, event.type) && Write(mFile, event.x) && Write(mFile, event.y);
+
+	if (!written)
+	{
+		std::cout << "ERROR::INPUT_LOG::WRITE_FAILED" << std::endl;
+		Close();
+		return false;
+	}
+
+	++mFrameCount;
+	return true;
+}
+
+bool InputLog::ReadFrame(Frame& frame)
+{
+	if (!IsReplaying())
+		return false;
+
+	uint32_t eventCount = 0;
+	if (!Read(mFile, frame.deltaTime) || !Read(mFile, frame.keys) || !Read(mFile, eventCount) ||
+		eventCount > MAX_EVENTS_PER_FRAME)
+		return false;
+
+	frame.events.resize(eventCount);
+	for (Event& event : frame.events)
+	{
+		if (!Read(mFile, event.type) || !Read(mFile, event.x) || !Read(mFile, event.y))
+			return false;
+	}
+
+	++mFrameCount;
+	return true;
+}
@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+// inputLog.h
+// ========
+// compact binary log of per-frame input, for recording and replaying runs
+//
+// Each frame stores its time step, the state of the polled keys as a bit
+// mask, and the window events (cursor, scroll, mouse button) in the order
+// they arrived. Replaying the log with the recorded time steps drives the
+// camera through exactly the same path on any machine: values are stored
+// as raw little-endian IEEE floats, never re-derived from the clock.
+//
+// File layout:
+//	header	"INPL", uint32 version
+//	frame	float deltaTime, uint32 keys, uint32 eventCount,
+//			eventCount x { uint8 type, double x, double y }
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+class InputLog
+{
+public:
+	enum EventType
+	{
+		EVENT_CURSOR,           // x, y: cursor position
+		EVENT_SCROLL,           // x, y: scroll offsets
+		EVENT_MOUSE_BUTTON      // x: button, y: action
+	};
+
+	struct Event
+	{
+		uint8_t type;
+		double x;
+		double y;
+	};
+
+	struct Frame
+	{
+		float deltaTime = 0.0f;
+		uint32_t keys = 0;              // Bit n set when polled key n was pressed
+		std::vector<Event> events;
+	};
+
+public:
+	~InputLog() { Close(); }
+
+	bool OpenForRecording(const char* path);
+	bool OpenForReplay(const char* path);
+	void Close();
+
+	bool IsRecording() const { return mFile && mRecording; }
+	bool IsReplaying() const { return mFile && !mRecording; }
+
+	// Append one frame to a log being recorded
+	bool WriteFrame(const Frame& frame);
+
+	// Read the next frame of a log being replayed; false at the end
+	bool ReadFrame(Frame& frame);
+
+	unsigned long long FrameCount() const { return mFrameCount; }
+
+private:
+	FILE* mFile = NULL;
+	bool mRecording = false;
+	unsigned long long mFrameCount = 0;
+};
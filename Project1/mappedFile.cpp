@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedFile.cpp
+// ========
+// read-only memory mapping of a whole file
+///////////////////////////////////////////////////////////////////////////////
+
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: mData(other.mData), mSize(other.mSize)
+{
+	other.mData = nullptr;
+	other.mSize = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		mData = other.mData;
+		mSize = other.mSize;
+		other.mData = nullptr;
+		other.mSize = 0;
+	}
+	return *this;
+}
+
+///////////////////////////////////////////////////
+//	Open(const char*)
+//
+//	path: file to map, whole, for reading
+//
+//	Any view already open is closed first
+///////////////////////////////////////////////////
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	HANDLE mapping = NULL;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+
+	// The view keeps the mapping alive on its own
+	mData = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!mData)
+		return false;
+
+	mSize = (size_t)size.QuadPart;
+#else
+	int file = open(path, O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat status;
+	void* view = MAP_FAILED;
+	if (fstat(file, &status) == 0 && status.st_size > 0)
+		view = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (view == MAP_FAILED)
+		return false;
+
+	mData = (const unsigned char*)view;
+	mSize = (size_t)status.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (!mData)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mData);
+#else
+	munmap((void*)mData, mSize);
+#endif
+
+	mData = nullptr;
+	mSize = 0;
+}
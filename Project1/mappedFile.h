@@ -0,0 +1,38 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedFile.h
+// ========
+// read-only memory mapping of a whole file
+//
+// The contents are paged in from the OS file cache as they are first
+// touched, so reading a mapped file costs no copy into a heap buffer. The
+// file itself is closed as soon as it is mapped; only the view is kept
+// until Close().
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { Close(); }
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// False if the file is missing, empty or cannot be mapped
+	bool Open(const char* path);
+	void Close();
+
+	bool IsOpen() const { return mData != nullptr; }
+	const unsigned char* Data() const { return mData; }
+	size_t Size() const { return mSize; }
+
+private:
+	const unsigned char* mData = nullptr;
+	size_t mSize = 0;
+};
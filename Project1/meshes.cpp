@@ -8,7 +8,10 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "meshes.h"
+#include "glResources.h"
+#include "glTrace.h"
 
+#include <utility>
 #include <vector>
 
 namespace
@@ -22,9 +25,13 @@ namespace
 //
 //	Create all the following 3D meshes:
 //		plane, pyramid, cube, cylinder, torus, sphere
+//	and upload them together as one geometry pool
 ///////////////////////////////////////////////////
 void Meshes::CreateMeshes()
 {
+	// Every mesh refers to the shared VAO
+	gPoolVao = CreateVertexArray();
+
 	UCreatePlaneMesh(gPlaneMesh);
 	UCreatePrismMesh(gPrismMesh);
 	UCreateBoxMesh(gBoxMesh);
@@ -35,6 +42,8 @@ void Meshes::CreateMeshes()
 	UCreatePyramid4Mesh(gPyramid4Mesh);
 	UCreateSphereMesh(gSphereMesh);
 	UCreateTorusMesh(gTorusMesh);
+
+	UUploadPool();
 }
 
 ///////////////////////////////////////////////////
@@ -44,15 +53,110 @@ void Meshes::CreateMeshes()
 ///////////////////////////////////////////////////
 void Meshes::DestroyMeshes()
 {
-	UDestroyMesh(gBoxMesh);
-	UDestroyMesh(gConeMesh);
-	UDestroyMesh(gCylinderMesh);
-	UDestroyMesh(gPlaneMesh);
-	UDestroyMesh(gPyramid3Mesh);
-	UDestroyMesh(gPyramid4Mesh);
-	UDestroyMesh(gPrismMesh);
-	UDestroyMesh(gSphereMesh);
-	UDestroyMesh(gTorusMesh);
+	glDeleteVertexArrays(1, &gPoolVao);
+	DeleteBuffer(gPoolVbos[0]);
+	DeleteBuffer(gPoolVbos[1]);
+
+	gPoolVao = 0;
+}
+
+///////////////////////////////////////////////////
+//	UAddToPool(GLMesh&, const GLfloat*, const GLuint*)
+//
+//	mesh: mesh with its vertex count and source parts set
+//	verts: interleaved position / normal / uv data
+//	indices: index data for the indexed parts, or NULL
+//
+//	Append the vertices of a mesh to the pool and
+//	rewrite every part as an indexed triangle list,
+//	so the whole pool can be drawn with GL_TRIANGLES
+///////////////////////////////////////////////////
+void Meshes::UAddToPool(GLMesh &mesh, const GLfloat* verts, const GLuint* indices)
+{
+	const GLuint floatsPerPoolVertex = 3 + 3 + 2;
+
+	mesh.vao = gPoolVao;
+	mesh.baseVertex = (GLint)(mPoolVertices.size() / floatsPerPoolVertex);
+	mesh.firstIndex = (GLuint)mPoolIndices.size();
+
+	mPoolVertices.insert(mPoolVertices.end(), verts, verts + mesh.nVertices * floatsPerPoolVertex);
+
+	std::vector<SubMesh> pooledParts;
+	for (const SubMesh& part : mesh.parts)
+	{
+		SubMesh pooled = { GL_TRIANGLES, (GLint)(mPoolIndices.size() - mesh.firstIndex), 0, true };
+
+		// Vertex referenced by the n-th element of the source part
+		auto source = [&](GLint n) -> GLuint {
+			return part.indexed ? indices[part.first + n] : (GLuint)(part.first + n);
+		};
+
+		switch (part.mode)
+		{
+		case GL_TRIANGLE_STRIP:
+			// Every other triangle of a strip is wound the other way
+			for (GLint i = 0; i + 2 < part.count; ++i)
+			{
+				GLuint a = source(i), b = source(i + 1), c = source(i + 2);
+				if (i % 2 != 0)
+					std::swap(a, b);
+				mPoolIndices.insert(mPoolIndices.end(), { a, b, c });
+			}
+			break;
+
+		case GL_TRIANGLE_FAN:
+			for (GLint i = 1; i + 1 < part.count; ++i)
+				mPoolIndices.insert(mPoolIndices.end(), { source(0), source(i), source(i + 1) });
+			break;
+
+		default:
+			for (GLint i = 0; i < part.count; ++i)
+				mPoolIndices.push_back(source(i));
+			break;
+		}
+
+		pooled.count = (GLsizei)(mPoolIndices.size() - mesh.firstIndex) - pooled.first;
+		pooledParts.push_back(pooled);
+	}
+
+	mesh.parts = pooledParts;
+	mesh.nIndices = (GLuint)mPoolIndices.size() - mesh.firstIndex;
+}
+
+///////////////////////////////////////////////////
+//	UUploadPool()
+//
+//	Send the staged vertices and indices to the GPU
+//	in immutable buffers and describe the shared
+//	vertex layout
+///////////////////////////////////////////////////
+void Meshes::UUploadPool()
+{
+	// total float values per each type
+	const GLuint floatsPerVertex = 3;
+	const GLuint floatsPerNormal = 3;
+	const GLuint floatsPerUV = 2;
+
+	// The pool is never modified after loading, so no storage flags are needed
+	gPoolVbos[0] = CreateImmutableBuffer(sizeof(GLfloat) * mPoolVertices.size(), mPoolVertices.data(), 0);
+	gPoolVbos[1] = CreateImmutableBuffer(sizeof(GLuint) * mPoolIndices.size(), mPoolIndices.data(), 0);
+
+	// Strides between vertex coordinates
+	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
+
+	// All three attributes read from vertex buffer binding 0
+	SetVertexBuffer(gPoolVao, 0, gPoolVbos[0], 0, stride);
+	SetElementBuffer(gPoolVao, gPoolVbos[1]);
+
+	SetVertexAttribute(gPoolVao, 0, 0, floatsPerVertex, GL_FLOAT, 0);
+	SetVertexAttribute(gPoolVao, 1, 0, floatsPerNormal, GL_FLOAT, sizeof(float) * floatsPerVertex);
+	SetVertexAttribute(gPoolVao, 2, 0, floatsPerUV, GL_FLOAT, sizeof(float) * (floatsPerVertex + floatsPerNormal));
+
+	// The GPU copy is all that is needed from here on
+	mPoolVertices.clear();
+	mPoolVertices.shrink_to_fit();
+	mPoolIndices.clear();
+	mPoolIndices.shrink_to_fit();
 }
 
 ///////////////////////////////////////////////////
@@ -60,7 +164,7 @@ void Meshes::DestroyMeshes()
 //
 //	mesh: reference to mesh structure for storing data
 //
-//	Create a plane mesh and store it in a VAO/VBO
+//	Create a plane mesh and append it to the geometry pool
 // 
 //  Correct triangle drawing command:
 //
@@ -92,30 +196,11 @@ void Meshes::UCreatePlaneMesh(GLMesh &mesh)
 	mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex + floatsPerNormal + floatsPerUV));
 	mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
 
-	// Generate the VAO for the mesh
-	glGenVertexArrays(1, &mesh.vao);
-	glBindVertexArray(mesh.vao);	// activate the VAO
-
-	// Create VBOs for the mesh
-	glGenBuffers(2, mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends data to the GPU
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]); // Activates the buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	// Strides between vertex coordinates
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
+	// store the drawing commands for the mesh
+	mesh.parts = { { GL_TRIANGLES, 0, (GLsizei)mesh.nIndices, true } };
 
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerVertex));
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-	glEnableVertexAttribArray(2);
+	// append the mesh to the shared geometry pool
+	UAddToPool(mesh, verts, indices);
 }
 
 ///////////////////////////////////////////////////
@@ -123,7 +208,7 @@ void Meshes::UCreatePlaneMesh(GLMesh &mesh)
 //
 //	mesh: reference to mesh structure for storing data
 //
-//	Create a pyramid mesh and store it in a VAO/VBO
+//	Create a pyramid mesh and append it to the geometry pool
 //
 //  Correct triangle drawing command:
 //
@@ -163,23 +248,11 @@ void Meshes::UCreatePyramid3Mesh(GLMesh &mesh)
 	// Calculate total defined vertices
 	mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex + floatsPerColor + floatsPerUV));
 
-	glGenVertexArrays(1, &mesh.vao);			// Creates 1 VAO
-	glGenBuffers(1, mesh.vbos);					// Creates 1 VBO
-	glBindVertexArray(mesh.vao);				// Activates the VAO
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]);	// Activates the VBO
-	// Sends vertex or coordinate data to the GPU
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
-
-	// Strides between sets of attribute data
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerColor + floatsPerUV);
-
-	// Creates the Vertex Attribute Pointers
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, floatsPerColor, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float)* floatsPerVertex));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float)* (floatsPerVertex + floatsPerColor)));
-	glEnableVertexAttribArray(2);
+	// store the drawing commands for the mesh
+	mesh.parts = { { GL_TRIANGLE_STRIP, 0, (GLsizei)mesh.nVertices, false } };
+
+	// append the mesh to the shared geometry pool
+	UAddToPool(mesh, verts, NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -187,7 +260,7 @@ void Meshes::UCreatePyramid3Mesh(GLMesh &mesh)
 //
 //	mesh: reference to mesh structure for storing data
 //
-//	Create a pyramid mesh and store it in a VAO/VBO
+//	Create a pyramid mesh and append it to the geometry pool
 //
 //  Correct triangle drawing command:
 //
@@ -236,23 +309,11 @@ void Meshes::UCreatePyramid4Mesh(GLMesh &mesh)
 	// Calculate total defined vertices
 	mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex + floatsPerColor + floatsPerUV));
 
-	glGenVertexArrays(1, &mesh.vao);			// Creates 1 VAO
-	glGenBuffers(1, mesh.vbos);					// Creates 1 VBO
-	glBindVertexArray(mesh.vao);				// Activates the VAO
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]);	// Activates the VBO
-	// Sends vertex or coordinate data to the GPU
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
-
-	// Strides between sets of attribute data
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerColor + floatsPerUV);
-
-	// Creates the Vertex Attribute Pointers
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, floatsPerColor, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float)* floatsPerVertex));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float)* (floatsPerVertex + floatsPerColor)));
-	glEnableVertexAttribArray(2);
+	// store the drawing commands for the mesh
+	mesh.parts = { { GL_TRIANGLE_STRIP, 0, (GLsizei)mesh.nVertices, false } };
+
+	// append the mesh to the shared geometry pool
+	UAddToPool(mesh, verts, NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -260,7 +321,7 @@ void Meshes::UCreatePyramid4Mesh(GLMesh &mesh)
 //
 //	mesh: reference to mesh structure for storing data
 //
-//	Create a pyramid mesh and store it in a VAO/VBO
+//	Create a pyramid mesh and append it to the geometry pool
 //
 //	Correct triangle drawing command:
 //
@@ -323,26 +384,11 @@ void Meshes::UCreatePrismMesh(GLMesh &mesh)
 
 	mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex + floatsPerNormal + floatsPerUV));
 
-	glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(mesh.vao);
-
-	// Create 2 buffers: first one for the vertex data; second one for the indices
-	glGenBuffers(1, mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	// Strides between vertex coordinates is 6 (x, y, z, r, g, b, a). A tightly packed stride is 0.
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);// The number of floats before each
+	// store the drawing commands for the mesh
+	mesh.parts = { { GL_TRIANGLE_STRIP, 0, (GLsizei)mesh.nVertices, false } };
 
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerVertex));
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-	glEnableVertexAttribArray(2);
+	// append the mesh to the shared geometry pool
+	UAddToPool(mesh, verts, NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -350,7 +396,7 @@ void Meshes::UCreatePrismMesh(GLMesh &mesh)
 //
 //	mesh: reference to mesh structure for storing data
 //
-//	Create a cube mesh and store it in a VAO/VBO
+//	Create a cube mesh and append it to the geometry pool
 //
 //	Correct triangle drawing command:
 //
@@ -423,29 +469,11 @@ void Meshes::UCreateBoxMesh(GLMesh &mesh)
 	mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex + floatsPerNormal + floatsPerUV));
 	mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
 
-	glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(mesh.vao);
-
-	// Create 2 buffers: first one for the vertex data; second one for the indices
-	glGenBuffers(2, mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]); // Activates the buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	// Strides between vertex coordinates is 6 (x, y, z, r, g, b, a). A tightly packed stride is 0.
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);// The number of floats before each
-
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerVertex));
-	glEnableVertexAttribArray(1);
+	// store the drawing commands for the mesh
+	mesh.parts = { { GL_TRIANGLES, 0, (GLsizei)mesh.nIndices, true } };
 
-	glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-	glEnableVertexAttribArray(2);
+	// append the mesh to the shared geometry pool
+	UAddToPool(mesh, verts, indices);
 }
 
 ///////////////////////////////////////////////////
@@ -453,7 +481,7 @@ void Meshes::UCreateBoxMesh(GLMesh &mesh)
 //
 //	mesh: reference to mesh structure for storing data
 //
-//	Create a cylinder mesh and store it in a VAO/VBO
+//	Create a cylinder mesh and append it to the geometry pool
 //
 //  Correct triangle drawing commands:
 //
@@ -621,27 +649,14 @@ void Meshes::UCreateConeMesh(GLMesh &mesh)
 	mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex + floatsPerNormal + floatsPerUV));
 	mesh.nIndices = 0;
 
-	// Create VAO
-	glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(mesh.vao);
-
-	// Create VBO
-	glGenBuffers(1, mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	// Strides between vertex coordinates
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, (void*)0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex)));
-	glEnableVertexAttribArray(1);
+	// store the drawing commands for the mesh
+	mesh.parts = {
+		{ GL_TRIANGLE_FAN, 0, 36, false },		//bottom
+		{ GL_TRIANGLE_STRIP, 36, 108, false }	//sides
+	};
 
-	glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-	glEnableVertexAttribArray(2);
+	// append the mesh to the shared geometry pool
+	UAddToPool(mesh, verts, NULL);
 }
 
 void Meshes::CalculateTriangleNormal(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2)
@@ -675,7 +690,7 @@ void Meshes::CalculateTriangleNormal(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2)
 //
 //	mesh: reference to mesh structure for storing data
 //
-//	Create a cylinder mesh and store it in a VAO/VBO
+//	Create a cylinder mesh and append it to the geometry pool
 //
 //  Correct triangle drawing commands:
 //
@@ -920,27 +935,15 @@ void Meshes::UCreateCylinderMesh(GLMesh &mesh)
 	mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex + floatsPerNormal + floatsPerUV));
 	mesh.nIndices = 0;
 
-	// Create VAO
-	glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(mesh.vao);
-
-	// Create VBO
-	glGenBuffers(1, mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	// Strides between vertex coordinates
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, (void*)0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex)));
-	glEnableVertexAttribArray(1);
+	// store the drawing commands for the mesh
+	mesh.parts = {
+		{ GL_TRIANGLE_FAN, 0, 36, false },		//bottom
+		{ GL_TRIANGLE_FAN, 36, 72, false },		//top
+		{ GL_TRIANGLE_STRIP, 72, 146, false }	//sides
+	};
 
-	glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-	glEnableVertexAttribArray(2);
+	// append the mesh to the shared geometry pool
+	UAddToPool(mesh, verts, NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -948,7 +951,7 @@ void Meshes::UCreateCylinderMesh(GLMesh &mesh)
 //
 //	mesh: reference to mesh structure for storing data
 //
-//	Create a tapered cylinder mesh and store it in a VAO/VBO
+//	Create a tapered cylinder mesh and append it to the geometry pool
 //
 //  Correct triangle drawing commands:
 //
@@ -1193,27 +1196,15 @@ void Meshes::UCreateTaperedCylinderMesh(GLMesh &mesh)
 	mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex + floatsPerNormal + floatsPerUV));
 	mesh.nIndices = 0;
 
-	// Create VAO
-	glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(mesh.vao);
-
-	// Create VBO
-	glGenBuffers(1, mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	// Strides between vertex coordinates
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, (void*)0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex)));
-	glEnableVertexAttribArray(1);
+	// store the drawing commands for the mesh
+	mesh.parts = {
+		{ GL_TRIANGLE_FAN, 0, 36, false },		//bottom
+		{ GL_TRIANGLE_FAN, 36, 72, false },		//top
+		{ GL_TRIANGLE_STRIP, 72, 146, false }	//sides
+	};
 
-	glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-	glEnableVertexAttribArray(2);
+	// append the mesh to the shared geometry pool
+	UAddToPool(mesh, verts, NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -1221,7 +1212,7 @@ void Meshes::UCreateTaperedCylinderMesh(GLMesh &mesh)
 //
 //	mesh: reference to mesh structure for storing data
 //
-//	Create a torus mesh and store it in a VAO/VBO
+//	Create a torus mesh and append it to the geometry pool
 //
 //	Correct triangle drawing command:
 //
@@ -1442,36 +1433,15 @@ void Meshes::UCreateTorusMesh(GLMesh &mesh)
 		combined_values.push_back(text_coord.y);
 	}
 
-	// total float values per each type
-	const GLuint floatsPerVertex = 3;
-	const GLuint floatsPerNormal = 3;
-	const GLuint floatsPerUV = 2;
-
 	// store vertex and index count
 	mesh.nVertices = vertex_list.size();
 	mesh.nIndices = 0;
 
-	// Create VAO
-	glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(mesh.vao);
-
-	// Create VBOs
-	glGenBuffers(1, mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	// store the drawing commands for the mesh
+	mesh.parts = { { GL_TRIANGLES, 0, (GLsizei)mesh.nVertices, false } };
 
-	// Strides between vertex coordinates
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerVertex));
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-	glEnableVertexAttribArray(2);
+	// append the mesh to the shared geometry pool
+	UAddToPool(mesh, combined_values.data(), NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -1479,7 +1449,7 @@ void Meshes::UCreateTorusMesh(GLMesh &mesh)
 //
 //	mesh: reference to mesh structure for storing data
 //
-//	Create a sphere mesh and store it in a VAO/VBO
+//	Create a sphere mesh and append it to the geometry pool
 //
 //  Correct triangle drawing command:
 //
@@ -2265,15 +2235,16 @@ void Meshes::UCreateSphereMesh(GLMesh &mesh)
 		240,225,241
 	};
 
-	// total float values per each type
+	// total float values per vertex
 	const GLuint floatsPerVertex = 3;
-	const GLuint floatsPerNormal = 3;
-	const GLuint floatsPerUV = 2;
 
 	// store vertex and index count
 	mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex));
 	mesh.nIndices = sizeof(indices) / (sizeof(indices[0]));
 
+	// store the drawing commands for the mesh
+	mesh.parts = { { GL_TRIANGLES, 0, (GLsizei)mesh.nIndices, true } };
+
 	glm::vec3 normal;
 	glm::vec3 vert;
 	glm::vec3 center(0.0f, 0.0f, 0.0f);
@@ -2297,34 +2268,6 @@ void Meshes::UCreateSphereMesh(GLMesh &mesh)
 		combined_values.push_back(v);
 	}
 
-	// Create VAO
-	glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(mesh.vao);
-
-	// Create VBOs
-	glGenBuffers(2, mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the vertex buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]); // Activates the index buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	// Strides between vertex coordinates
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerVertex));
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-	glEnableVertexAttribArray(2);
+	// append the mesh to the shared geometry pool
+	UAddToPool(mesh, combined_values.data(), indices);
 }
-
-void Meshes::UDestroyMesh(GLMesh &mesh)
-{
-	glDeleteVertexArrays(1, &mesh.vao);
-	glDeleteBuffers(2, mesh.vbos);
-}
\ No newline at end of file
@@ -1,10 +1,14 @@
-///////////////////////////////////////////////////////////////////////////////
-// meshes.h
-// ========
-// create meshes for various 3D primitives: plane, pyramid, cube, cylinder, torus, sphere
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 7th, 2022
+///////////////////////////////////////////////////////////////////////////////
+// meshes.h
+// ========
+// create meshes for various 3D primitives: plane, pyramid, cube, cylinder, torus, sphere
+//
+// All primitives are packed into one shared vertex buffer and one shared
+// index buffer behind a single VAO, so a scene mixing primitives never
+// switches vertex state. Every part is stored as an indexed triangle list.
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 7th, 2022
 ///////////////////////////////////////////////////////////////////////////////
 
 #pragma once
@@ -13,17 +17,38 @@
 
 #include <glm/glm.hpp>
 
+#include <vector>
+
 class Meshes
 {
+public:
+	// Contiguous part of a mesh drawn with a single primitive mode. While a
+	// mesh is being built this describes its source data; once the mesh is
+	// in the pool every part is GL_TRIANGLES, indexed, with first relative
+	// to the mesh's firstIndex.
+	struct SubMesh
+	{
+		GLenum mode;        // Primitive type (GL_TRIANGLES, GL_TRIANGLE_FAN, ...)
+		GLint first;        // First vertex, or first index when indexed
+		GLsizei count;      // Number of vertices, or indices when indexed
+		bool indexed;       // Drawn with glDrawElements from the index buffer
+	};
+
 	// Stores the GL data relative to a given mesh
 	struct GLMesh
 	{
-		GLuint vao;         // Handle for the vertex array object
-		GLuint vbos[2];     // Handles for the vertex buffer objects
+		GLuint vao;         // Handle for the shared vertex array object
 		GLuint nVertices;	// Number of vertices for the mesh
-		GLuint nIndices;    // Number of indices for the mesh
+		GLuint nIndices;    // Number of indices for the mesh, in the pool
+		GLint baseVertex;   // First vertex of the mesh in the shared vertex buffer
+		GLuint firstIndex;  // First index of the mesh in the shared index buffer
+		std::vector<SubMesh> parts;	// Drawing commands that make up the whole mesh
 	};
 
+	// Part indices for the multi-part meshes
+	enum CylinderPart { CYLINDER_BOTTOM, CYLINDER_TOP, CYLINDER_SIDES };
+	enum ConePart { CONE_BOTTOM, CONE_SIDES };
+
 public:
 	GLMesh gBoxMesh;
 	GLMesh gConeMesh;
@@ -36,10 +61,20 @@ public:
 	GLMesh gPyramid4Mesh;
 	GLMesh gTorusMesh;
 
+	// Shared geometry pool
+	GLuint gPoolVao = 0;
+	GLuint gPoolVbos[2] = { 0, 0 };
+
 public:
 	void CreateMeshes();
 	void DestroyMeshes();
 
+	// CPU-only geometry building for the benchmarks: the mesh is built into
+	// the staging pool, which is never uploaded; clear it between runs
+	void BuildSphereGeometry(GLMesh &mesh) { UCreateSphereMesh(mesh); }
+	void BuildTorusGeometry(GLMesh &mesh) { UCreateTorusMesh(mesh); }
+	void ClearStagedGeometry() { mPoolVertices.clear(); mPoolIndices.clear(); }
+
 private:
 	void UCreatePlaneMesh(GLMesh &mesh);
 	void UCreatePrismMesh(GLMesh &mesh);
@@ -52,7 +87,12 @@ private:
 	void UCreatePyramid4Mesh(GLMesh &mesh);
 	void UCreateSphereMesh(GLMesh &mesh);
 
-	void UDestroyMesh(GLMesh &mesh);
+	void UAddToPool(GLMesh &mesh, const GLfloat* verts, const GLuint* indices);
+	void UUploadPool();
+
+	// Pool contents staged on the CPU until UUploadPool()
+	std::vector<GLfloat> mPoolVertices;
+	std::vector<GLuint> mPoolIndices;
 
 	void CalculateTriangleNormal(glm::vec3 px, glm::vec3 py, glm::vec3 pz);
 };
\ No newline at end of file
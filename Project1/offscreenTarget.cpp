@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreenTarget.cpp
+// ========
+// framebuffer object with a color and a depth attachment, rendered to in
+// place of a window's default framebuffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "offscreenTarget.h"
+#include "gpuMemory.h"
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+///////////////////////////////////////////////////
+//	Create(GLsizei, GLsizei)
+//
+//	width, height: size of the target in pixels
+//
+//	Build the framebuffer and check it is complete
+///////////////////////////////////////////////////
+bool OffscreenTarget::Create(GLsizei targetWidth, GLsizei targetHeight)
+{
+	width = targetWidth;
+	height = targetHeight;
+
+	glGenRenderbuffers(1, &mColor);
+	glBindRenderbuffer(GL_RENDERBUFFER, mColor);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &mDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, mDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GpuMemory::Track(GpuMemory::CATEGORY_RENDERBUFFER, mColor, GpuMemory::TextureBytes(GL_RGBA8, width, height, 1));
+	GpuMemory::Track(GpuMemory::CATEGORY_RENDERBUFFER, mDepth, GpuMemory::TextureBytes(GL_DEPTH_COMPONENT24, width, height, 1));
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColor);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepth);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::OFFSCREEN_TARGET::INCOMPLETE status 0x" << std::hex << status << std::dec << std::endl;
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void OffscreenTarget::Destroy()
+{
+	GpuMemory::Release(GpuMemory::CATEGORY_RENDERBUFFER, mColor);
+	GpuMemory::Release(GpuMemory::CATEGORY_RENDERBUFFER, mDepth);
+
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &mColor);
+	glDeleteRenderbuffers(1, &mDepth);
+
+	framebuffer = mColor = mDepth = 0;
+}
+
+void OffscreenTarget::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
+}
+
+///////////////////////////////////////////////////
+//	WritePpm(const char*)
+//
+//	path: image file to write
+//
+//	Read back the color attachment, flip it to top-
+//	down row order and write it as a binary PPM.
+//	Waits for the GPU; meant for the end of a run.
+///////////////////////////////////////////////////
+bool OffscreenTarget::WritePpm(const char* path) const
+{
+	std::vector<unsigned char> pixels((size_t)width * height * 3);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+	FILE* file = fopen(path, "wb");
+	if (!file)
+	{
+		std::cout << "ERROR::OFFSCREEN_TARGET::CANNOT_WRITE " << path << std::endl;
+		return false;
+	}
+
+	fprintf(file, "P6\n%d %d\n255\n", (int)width, (int)height);
+
+	// OpenGL rows start at the bottom
+	const size_t rowSize = (size_t)width * 3;
+	for (GLsizei row = height - 1; row >= 0; --row)
+		fwrite(pixels.data() + row * rowSize, 1, rowSize, file);
+
+	fclose(file);
+	return true;
+}
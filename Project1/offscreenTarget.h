@@ -0,0 +1,32 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreenTarget.h
+// ========
+// framebuffer object with a color and a depth attachment, rendered to in
+// place of a window's default framebuffer
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+class OffscreenTarget
+{
+public:
+	// Allocate RGBA8 color and 24-bit depth renderbuffers; false if incomplete
+	bool Create(GLsizei width, GLsizei height);
+	void Destroy();
+
+	// Make the target the draw and read framebuffer and cover it with the viewport
+	void Bind() const;
+
+	// Read the color attachment back and store it as a binary PPM
+	bool WritePpm(const char* path) const;
+
+	GLuint framebuffer = 0;
+	GLsizei width = 0;
+	GLsizei height = 0;
+
+private:
+	GLuint mColor = 0;
+	GLuint mDepth = 0;
+};
@@ -0,0 +1,408 @@
+///////////////////////////////////////////////////////////////////////////////
+// perfHud.cpp
+// ========
+// on-screen performance overlay drawn with a single batched call
+///////////////////////////////////////////////////////////////////////////////
+
+#include "perfHud.h"
+#include "glResources.h"
+#include "glTrace.h"
+#include "cpuProfiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	// 8x8 glyphs for ASCII 32..126, one byte per row from the top, least
+	// significant bit leftmost (public domain font8x8_basic)
+	const unsigned char FONT_GLYPHS[95][8] =
+	{
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // ' '
+		{ 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 },   // '!'
+		{ 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '"'
+		{ 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 },   // '#'
+		{ 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 },   // '$'
+		{ 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 },   // '%'
+		{ 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 },   // '&'
+		{ 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '''
+		{ 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 },   // '('
+		{ 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 },   // ')'
+		{ 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 },   // '*'
+		{ 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 },   // '+'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 },   // ','
+		{ 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 },   // '-'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 },   // '.'
+		{ 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 },   // '/'
+		{ 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 },   // '0'
+		{ 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 },   // '1'
+		{ 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 },   // '2'
+		{ 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 },   // '3'
+		{ 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 },   // '4'
+		{ 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 },   // '5'
+		{ 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 },   // '6'
+		{ 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 },   // '7'
+		{ 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 },   // '8'
+		{ 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 },   // '9'
+		{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 },   // ':'
+		{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 },   // ';'
+		{ 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 },   // '<'
+		{ 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 },   // '='
+		{ 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 },   // '>'
+		{ 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 },   // '?'
+		{ 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 },   // '@'
+		{ 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 },   // 'A'
+		{ 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 },   // 'B'
+		{ 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 },   // 'C'
+		{ 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 },   // 'D'
+		{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 },   // 'E'
+		{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 },   // 'F'
+		{ 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 },   // 'G'
+		{ 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 },   // 'H'
+		{ 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },   // 'I'
+		{ 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 },   // 'J'
+		{ 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 },   // 'K'
+		{ 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 },   // 'L'
+		{ 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 },   // 'M'
+		{ 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 },   // 'N'
+		{ 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 },   // 'O'
+		{ 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 },   // 'P'
+		{ 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 },   // 'Q'
+		{ 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 },   // 'R'
+		{ 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 },   // 'S'
+		{ 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },   // 'T'
+		{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 },   // 'U'
+		{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },   // 'V'
+		{ 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 },   // 'W'
+		{ 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 },   // 'X'
+		{ 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 },   // 'Y'
+		{ 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 },   // 'Z'
+		{ 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 },   // '['
+		{ 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 },   // '\'
+		{ 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 },   // ']'
+		{ 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 },   // '^'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF },   // '_'
+		{ 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '`'
+		{ 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 },   // 'a'
+		{ 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 },   // 'b'
+		{ 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 },   // 'c'
+		{ 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 },   // 'd'
+		{ 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 },   // 'e'
+		{ 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 },   // 'f'
+		{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F },   // 'g'
+		{ 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 },   // 'h'
+		{ 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },   // 'i'
+		{ 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E },   // 'j'
+		{ 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 },   // 'k'
+		{ 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },   // 'l'
+		{ 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 },   // 'm'
+		{ 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 },   // 'n'
+		{ 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 },   // 'o'
+		{ 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F },   // 'p'
+		{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 },   // 'q'
+		{ 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 },   // 'r'
+		{ 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 },   // 's'
+		{ 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 },   // 't'
+		{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 },   // 'u'
+		{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },   // 'v'
+		{ 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 },   // 'w'
+		{ 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 },   // 'x'
+		{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F },   // 'y'
+		{ 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 },   // 'z'
+		{ 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 },   // '{'
+		{ 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 },   // '|'
+		{ 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 },   // '}'
+		{ 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '~'
+	};
+
+	const int FIRST_GLYPH = 32;
+	const int GLYPH_COUNT = 95;
+	const int GLYPH_SIZE = 8;
+
+	// Atlas of 16 x 6 cells; the cell after '~' is solid, for panels and bars
+	const int ATLAS_COLUMNS = 16;
+	const int ATLAS_ROWS = 6;
+	const int ATLAS_WIDTH = ATLAS_COLUMNS * GLYPH_SIZE;
+	const int ATLAS_HEIGHT = ATLAS_ROWS * GLYPH_SIZE;
+	const int SOLID_CELL = GLYPH_COUNT;
+
+	// On-screen layout, in pixels
+	const float SCALE = 2.0f;                       // Screen pixels per font pixel
+	const float CHAR_SIZE = GLYPH_SIZE * SCALE;
+	const float LINE_HEIGHT = CHAR_SIZE + 4.0f;
+	const float MARGIN = 10.0f;
+	const float PADDING = 8.0f;
+	const float PANEL_WIDTH = 22 * CHAR_SIZE + 2 * PADDING;
+	const float GRAPH_BAR_WIDTH = 2.0f;
+	const float GRAPH_HEIGHT = 60.0f;
+	const float GRAPH_FULL_SCALE_MS = 33.3f;        // Two frames at 60 Hz
+	const float GRAPH_TARGET_MS = 16.7f;
+
+	const glm::vec4 PANEL_COLOR(0.0f, 0.0f, 0.0f, 0.6f);
+	const glm::vec4 TEXT_COLOR(1.0f, 1.0f, 1.0f, 1.0f);
+	const glm::vec4 LABEL_COLOR(0.7f, 0.7f, 0.7f, 1.0f);
+	const glm::vec4 CPU_COLOR(0.3f, 0.8f, 1.0f, 0.9f);
+	const glm::vec4 GPU_COLOR(0.5f, 1.0f, 0.4f, 0.9f);
+	const glm::vec4 OVER_COLOR(1.0f, 0.3f, 0.2f, 0.9f);
+	const glm::vec4 TARGET_COLOR(1.0f, 1.0f, 1.0f, 0.35f);
+
+	glm::vec2 CellOrigin(int cell)
+	{
+		return glm::vec2((float)(cell % ATLAS_COLUMNS * GLYPH_SIZE) / ATLAS_WIDTH,
+			(float)(cell / ATLAS_COLUMNS * GLYPH_SIZE) / ATLAS_HEIGHT);
+	}
+
+	double Megabytes(size_t bytes)
+	{
+		return bytes / (1024.0 * 1024.0);
+	}
+}
+
+///////////////////////////////////////////////////
+//	Create(const ShaderProgram&)
+//
+//	program: linked overlay program
+//
+//	Bake the font atlas and build the static quad
+//	indices and the vertex layout
+///////////////////////////////////////////////////
+bool PerfHud::Create(const ShaderProgram& program)
+{
+	mProgram = program.id;
+	mViewportSize = program.GetUniform<glm::vec2>("uViewportSize");
+	mAtlasSampler = program.GetSampler("uAtlas");
+	if (!mViewportSize.IsValid() || !mAtlasSampler.IsValid())
+	{
+		std::cout << "ERROR::PERF_HUD::PROGRAM_MISSING_UNIFORMS" << std::endl;
+		return false;
+	}
+
+	// Expand the glyph bits into one byte per texel
+	std::vector<unsigned char> texels(ATLAS_WIDTH * ATLAS_HEIGHT, 0);
+	for (int cell = 0; cell <= SOLID_CELL; ++cell)
+	{
+		int cellX = cell % ATLAS_COLUMNS * GLYPH_SIZE;
+		int cellY = cell / ATLAS_COLUMNS * GLYPH_SIZE;
+		for (int y = 0; y < GLYPH_SIZE; ++y)
+		{
+			for (int x = 0; x < GLYPH_SIZE; ++x)
+			{
+				bool set = cell == SOLID_CELL || (FONT_GLYPHS[cell][y] >> x) & 1;
+				texels[(cellY + y) * ATLAS_WIDTH + cellX + x] = set ? 255 : 0;
+			}
+		}
+	}
+
+	mAtlas = CreateImmutableTexture2D(GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT, 1);
+	SetTextureParameter(mAtlas, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	SetTextureParameter(mAtlas, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	SetTextureParameter(mAtlas, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	SetTextureParameter(mAtlas, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// Rows of a one-byte format are not 4-byte aligned in general
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	UploadTexture2D(mAtlas, 0, ATLAS_WIDTH, ATLAS_HEIGHT, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// Every quad is two triangles over its four vertices
+	std::vector<GLushort> indices(MAX_QUADS * 6);
+	for (int quad = 0; quad < MAX_QUADS; ++quad)
+	{
+		GLushort first = (GLushort)(quad * 4);
+		GLushort* index = &indices[quad * 6];
+		index[0] = first;
+		index[1] = first + 1;
+		index[2] = first + 2;
+		index[3] = first;
+		index[4] = first + 2;
+		index[5] = first + 3;
+	}
+	mIndexBuffer = CreateImmutableBuffer(indices.size() * sizeof(GLushort), indices.data(), 0);
+
+	// The vertex stream itself is attached to the ring every frame
+	mVao = CreateVertexArray();
+	SetVertexAttribute(mVao, 0, 0, 2, GL_FLOAT, offsetof(Vertex, position));
+	SetVertexAttribute(mVao, 1, 0, 2, GL_FLOAT, offsetof(Vertex, uv));
+	SetVertexAttribute(mVao, 2, 0, 4, GL_FLOAT, offsetof(Vertex, color));
+	SetElementBuffer(mVao, mIndexBuffer);
+
+	mVertices.reserve(MAX_QUADS * 4);
+	mLastFrame = std::chrono::steady_clock::now();
+	return true;
+}
+
+void PerfHud::Destroy()
+{
+	glDeleteVertexArrays(1, &mVao);
+	DeleteBuffer(mIndexBuffer);
+	DeleteTexture(mAtlas);
+
+	mVao = 0;
+	mProgram = 0;
+}
+
+void PerfHud::AddFrame(const FrameStats& stats)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	double frameMs = std::chrono::duration<double, std::milli>(now - mLastFrame).count();
+	mLastFrame = now;
+
+	mCpuHistory[mNextSample] = (float)stats.cpuMs;
+	mGpuHistory[mNextSample] = (float)std::max(stats.gpuMs, 0.0);
+	mFrameHistory[mNextSample] = (float)frameMs;
+	mNextSample = (mNextSample + 1) % HISTORY_SIZE;
+	mSamples = std::min(mSamples + 1, HISTORY_SIZE);
+
+	mLast = stats;
+}
+
+///////////////////////////////////////////////////
+//	Draw(RingBuffer&, GLsizei, GLsizei)
+//
+//	ring: per-frame ring the vertices are written to
+//	viewportWidth, viewportHeight: target size in pixels
+//
+//	Build every quad of the overlay on the CPU, copy
+//	them into the ring and issue one indexed draw
+///////////////////////////////////////////////////
+void PerfHud::Draw(RingBuffer& ring, GLsizei viewportWidth, GLsizei viewportHeight)
+{
+	PROFILE_ZONE("PerfHud");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	mVertices.clear();
+
+	// The frame rate is averaged over the history so the text stays readable
+	double frameMsSum = 0.0;
+	for (int i = 0; i < mSamples; ++i)
+		frameMsSum += mFrameHistory[i];
+	double fps = frameMsSum > 0.0 ? mSamples * 1000.0 / frameMsSum : 0.0;
+
+	const int LINE_COUNT = 5;
+	const float graphsHeight = 2 * (LINE_HEIGHT + GRAPH_HEIGHT + PADDING);
+	glm::vec2 origin(MARGIN, MARGIN);
+	AddRect(origin, origin + glm::vec2(PANEL_WIDTH, 2 * PADDING + LINE_COUNT * LINE_HEIGHT + graphsHeight), PANEL_COLOR);
+
+	char line[64];
+	glm::vec2 cursor = origin + glm::vec2(PADDING);
+
+	snprintf(line, sizeof(line), "FPS %.1f", fps);
+	AddText(cursor, line, TEXT_COLOR);
+	cursor.y += LINE_HEIGHT;
+
+	if (mLast.gpuMs >= 0.0)
+		snprintf(line, sizeof(line), "CPU %.2f GPU %.2f ms", mLast.cpuMs, mLast.gpuMs);
+	else
+		snprintf(line, sizeof(line), "CPU %.2f GPU - ms", mLast.cpuMs);
+	AddText(cursor, line, TEXT_COLOR);
+	cursor.y += LINE_HEIGHT;
+
+	snprintf(line, sizeof(line), "Draws %u Objects %u", mLast.drawCalls, mLast.objects);
+	AddText(cursor, line, TEXT_COLOR);
+	cursor.y += LINE_HEIGHT;
+
+	snprintf(line, sizeof(line), "Tex %.1f Buf %.1f MB", Megabytes(mLast.textureBytes), Megabytes(mLast.bufferBytes));
+	AddText(cursor, line, TEXT_COLOR);
+	cursor.y += LINE_HEIGHT;
+
+	// The overlay's own cost, CPU then GPU
+	snprintf(line, sizeof(line), "HUD %.3f/%.3f ms", mCpuMs, std::max(mLast.hudGpuMs, 0.0));
+	AddText(cursor, line, LABEL_COLOR);
+	cursor.y += LINE_HEIGHT;
+
+	AddGraph(cursor, "CPU ms", mCpuHistory, CPU_COLOR);
+	cursor.y += LINE_HEIGHT + GRAPH_HEIGHT + PADDING;
+	AddGraph(cursor, "GPU ms", mGpuHistory, GPU_COLOR);
+
+	// Stream the vertices through the ring; when it is full the ring grows next frame
+	GLsizeiptr bytes = mVertices.size() * sizeof(Vertex);
+	RingBuffer::Allocation allocation = ring.Allocate(bytes, sizeof(glm::vec4));
+	if (allocation.IsValid())
+	{
+		memcpy(allocation.data, mVertices.data(), bytes);
+		SetVertexBuffer(mVao, 0, ring.id, allocation.offset, sizeof(Vertex));
+
+		glUseProgram(mProgram);
+		SetUniform(mViewportSize, glm::vec2((float)viewportWidth, (float)viewportHeight));
+		SetUniform(mAtlasSampler, 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, mAtlas);
+
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		glBindVertexArray(mVao);
+		glDrawElements(GL_TRIANGLES, (GLsizei)(mVertices.size() / 4 * 6), GL_UNSIGNED_SHORT, NULL);
+		glBindVertexArray(0);
+
+		glDisable(GL_BLEND);
+		glEnable(GL_DEPTH_TEST);
+	}
+
+	mCpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PerfHud::AddQuad(const glm::vec2& min, const glm::vec2& max, const glm::vec2& uvMin, const glm::vec2& uvMax, const glm::vec4& color)
+{
+	if (mVertices.size() >= MAX_QUADS * 4)
+		return;
+
+	mVertices.push_back({ glm::vec2(min.x, min.y), glm::vec2(uvMin.x, uvMin.y), color });
+	mVertices.push_back({ glm::vec2(max.x, min.y), glm::vec2(uvMax.x, uvMin.y), color });
+	mVertices.push_back({ glm::vec2(max.x, max.y), glm::vec2(uvMax.x, uvMax.y), color });
+	mVertices.push_back({ glm::vec2(min.x, max.y), glm::vec2(uvMin.x, uvMax.y), color });
+}
+
+void PerfHud::AddRect(const glm::vec2& min, const glm::vec2& max, const glm::vec4& color)
+{
+	// Sample the middle of the solid cell so no neighbouring glyph bleeds in
+	glm::vec2 uv = CellOrigin(SOLID_CELL) + glm::vec2(0.5f * GLYPH_SIZE / ATLAS_WIDTH, 0.5f * GLYPH_SIZE / ATLAS_HEIGHT);
+	AddQuad(min, max, uv, uv, color);
+}
+
+void PerfHud::AddText(const glm::vec2& position, const char* text, const glm::vec4& color)
+{
+	const glm::vec2 cellSize((float)GLYPH_SIZE / ATLAS_WIDTH, (float)GLYPH_SIZE / ATLAS_HEIGHT);
+
+	glm::vec2 pen = position;
+	for (const char* c = text; *c; ++c, pen.x += CHAR_SIZE)
+	{
+		int glyph = (unsigned char)*c - FIRST_GLYPH;
+		if (glyph <= 0 || glyph >= GLYPH_COUNT)
+			continue;
+
+		glm::vec2 uv = CellOrigin(glyph);
+		AddQuad(pen, pen + glm::vec2(CHAR_SIZE), uv, uv + cellSize, color);
+	}
+}
+
+///////////////////////////////////////////////////
+//	AddGraph(const glm::vec2&, const char*, const float*, const glm::vec4&)
+//
+//	One bar per frame of the history, oldest on the
+//	left; bars over the full scale are clamped and
+//	drawn in the warning color
+///////////////////////////////////////////////////
+void PerfHud::AddGraph(const glm::vec2& position, const char* label, const float* history, const glm::vec4& color)
+{
+	AddText(position, label, LABEL_COLOR);
+
+	glm::vec2 bottomLeft = position + glm::vec2(0.0f, LINE_HEIGHT + GRAPH_HEIGHT);
+	int first = mSamples < HISTORY_SIZE ? 0 : mNextSample;
+	for (int i = 0; i < mSamples; ++i)
+	{
+		float ms = history[(first + i) % HISTORY_SIZE];
+		float height = std::min(ms / GRAPH_FULL_SCALE_MS, 1.0f) * GRAPH_HEIGHT;
+		float x = bottomLeft.x + i * GRAPH_BAR_WIDTH;
+		AddRect(glm::vec2(x, bottomLeft.y - height), glm::vec2(x + GRAPH_BAR_WIDTH, bottomLeft.y),
+			ms > GRAPH_FULL_SCALE_MS ? OVER_COLOR : color);
+	}
+
+	// Frame budget line at 60 Hz
+	float targetY = bottomLeft.y - GRAPH_TARGET_MS / GRAPH_FULL_SCALE_MS * GRAPH_HEIGHT;
+	AddRect(glm::vec2(bottomLeft.x, targetY), glm::vec2(bottomLeft.x + HISTORY_SIZE * GRAPH_BAR_WIDTH, targetY + 1.0f), TARGET_COLOR);
+}
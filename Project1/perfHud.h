@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// perfHud.h
+// ========
+// on-screen performance overlay drawn with a single batched call
+//
+// The overlay shows the frame rate, CPU and GPU frame time graphs, the
+// scene's draw count and the texture and buffer memory in use, plus what
+// the overlay itself cost. Text comes from an 8x8 bitmap font baked into
+// a one-channel atlas at creation; panels and graph bars use a solid cell
+// of the same atlas. Every quad of a frame is written into the per-frame
+// ring, so the whole overlay is one indexed draw from one vertex stream.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <vector>
+
+#include "ringBuffer.h"
+#include "shaderProgram.h"
+
+class PerfHud
+{
+public:
+	// What one frame cost, as measured by the renderer
+	struct FrameStats
+	{
+		double cpuMs;               // CPU time spent building and submitting the frame
+		double gpuMs;               // GPU time of the frame, negative when not measured
+		double hudGpuMs;            // GPU time of an earlier overlay, negative when not measured
+		unsigned int drawCalls;     // Draw calls the scene issued
+		unsigned int objects;       // Items those calls drew
+		size_t textureBytes;
+		size_t bufferBytes;
+	};
+
+	// Frames kept for the graphs
+	static const int HISTORY_SIZE = 120;
+
+	// Quads one overlay may hold; more are dropped
+	static const int MAX_QUADS = 2048;
+
+public:
+	// program: linked overlay program with uViewportSize and uAtlas
+	bool Create(const ShaderProgram& program);
+	void Destroy();
+	bool IsCreated() const { return mVao != 0; }
+
+	// Record a frame for the text and the graphs
+	void AddFrame(const FrameStats& stats);
+
+	// Lay the overlay out in the ring and draw it over the current framebuffer
+	void Draw(RingBuffer& ring, GLsizei viewportWidth, GLsizei viewportHeight);
+
+	// CPU time of the last Draw(), layout and submission included
+	double LastCpuMs() const { return mCpuMs; }
+
+private:
+	struct Vertex
+	{
+		glm::vec2 position;         // Pixels from the top-left corner
+		glm::vec2 uv;
+		glm::vec4 color;
+	};
+
+	void AddQuad(const glm::vec2& min, const glm::vec2& max, const glm::vec2& uvMin, const glm::vec2& uvMax, const glm::vec4& color);
+	void AddRect(const glm::vec2& min, const glm::vec2& max, const glm::vec4& color);
+	void AddText(const glm::vec2& position, const char* text, const glm::vec4& color);
+	void AddGraph(const glm::vec2& position, const char* label, const float* history, const glm::vec4& color);
+
+	GLuint mProgram = 0;
+	Uniform<glm::vec2> mViewportSize;
+	Uniform<int> mAtlasSampler;
+
+	GLuint mAtlas = 0;
+	GLuint mVao = 0;
+	GLuint mIndexBuffer = 0;        // Static quad indices shared by every frame
+
+	std::vector<Vertex> mVertices;
+
+	// Rolling histories, in milliseconds
+	float mCpuHistory[HISTORY_SIZE] = {};
+	float mGpuHistory[HISTORY_SIZE] = {};
+	float mFrameHistory[HISTORY_SIZE] = {};
+	int mNextSample = 0;
+	int mSamples = 0;
+
+	FrameStats mLast = {};
+	std::chrono::steady_clock::time_point mLastFrame;
+	double mCpuMs = 0.0;
+};
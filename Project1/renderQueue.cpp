@@ -0,0 +1,375 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderQueue.cpp
+// ========
+// collects draw items for a frame, sorts them by a packed 64-bit state key
+// and submits them as multi-draw indirect commands with as few GL state
+// changes as possible
+///////////////////////////////////////////////////////////////////////////////
+
+#include "renderQueue.h"
+#include "glTrace.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace
+{
+	const int PROGRAM_SHIFT = 56;
+	const int VAO_SHIFT = 44;
+	const int TEXTURE_SHIFT = 32;
+	const int RANGE_SHIFT = 24;
+
+	const uint32_t MAX_PROGRAM_SLOTS = 1u << 8;
+	const uint32_t MAX_VAO_SLOTS = 1u << 12;
+	const uint32_t MAX_TEXTURE_SLOTS = 1u << 12;
+	const uint32_t MAX_RANGE_SLOTS = 1u << 8;
+	const uint32_t MAX_DEPTH = (1u << 24) - 1;
+
+	const GLuint NO_STATE = 0xFFFFFFFFu;
+}
+
+///////////////////////////////////////////////////
+//	Clear()
+//
+//	Drop the items of the previous frame, keeping
+//	the allocations for the next one
+///////////////////////////////////////////////////
+void RenderQueue::Clear()
+{
+	mItems.clear();
+	mEntries.clear();
+}
+
+///////////////////////////////////////////////////
+//	Submit(...)
+//
+//	Queue one pooled mesh range and build its sort
+//	key. Pooled ranges are always indexed triangles.
+///////////////////////////////////////////////////
+void RenderQueue::Submit(GLuint program, const Meshes::GLMesh& mesh, const Meshes::SubMesh& range,
+	GLuint materialIndex, GLuint texture, GLuint transformIndex, float viewDepth, uint8_t group)
+{
+	DrawItem item;
+	item.program = program;
+	item.vao = mesh.vao;
+	item.texture = texture;
+	item.materialIndex = materialIndex;
+	item.firstIndex = mesh.firstIndex + range.first;
+	item.count = range.count;
+	item.baseVertex = mesh.baseVertex;
+	item.transformIndex = transformIndex;
+	item.group = mGrouping ? group : 0;
+
+	// Identify the range by where it starts in the pool and how long it is
+	uint64_t rangeHandle = ((uint64_t)item.firstIndex << 32) ^ ((uint64_t)item.baseVertex << 20) ^ (uint64_t)item.count;
+
+	float normalizedDepth = std::min(std::max(viewDepth / depthRange, 0.0f), 1.0f);
+
+	uint64_t key = 0;
+	key |= (uint64_t)Slot(mProgramSlots, program, MAX_PROGRAM_SLOTS) << PROGRAM_SHIFT;
+	key |= (uint64_t)Slot(mVaoSlots, mesh.vao, MAX_VAO_SLOTS) << VAO_SHIFT;
+	key |= (uint64_t)Slot(mTextureSlots, texture, MAX_TEXTURE_SLOTS) << TEXTURE_SHIFT;
+	key |= (uint64_t)Slot(mRangeSlots, rangeHandle, MAX_RANGE_SLOTS) << RANGE_SHIFT;
+	key |= (uint64_t)(normalizedDepth * MAX_DEPTH);
+
+	SortEntry entry;
+	entry.key = key;
+	entry.item = (uint32_t)mItems.size();
+
+	mItems.push_back(item);
+	mEntries.push_back(entry);
+}
+
+///////////////////////////////////////////////////
+//	Sort()
+//
+//	LSD radix sort of the keys, one byte per pass.
+//	Passes where every key shares the same byte are
+//	skipped, which is the common case for the upper
+//	bytes in small scenes. With grouping enabled, a
+//	last stable pass on the group id makes it the
+//	most significant digit.
+///////////////////////////////////////////////////
+void RenderQueue::Sort()
+{
+	const size_t count = mEntries.size();
+	if (count < 2)
+		return;
+
+	mScratch.resize(count);
+
+	SortEntry* src = mEntries.data();
+	SortEntry* dst = mScratch.data();
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t histogram[256] = {};
+		for (size_t i = 0; i < count; ++i)
+			++histogram[(src[i].key >> shift) & 0xFF];
+
+		// Every key has the same digit: nothing to reorder
+		if (histogram[(src[0].key >> shift) & 0xFF] == count)
+			continue;
+
+		size_t offset = 0;
+		for (int digit = 0; digit < 256; ++digit)
+		{
+			size_t bucketSize = histogram[digit];
+			histogram[digit] = offset;
+			offset += bucketSize;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+			dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+		std::swap(src, dst);
+	}
+
+	if (mGrouping)
+	{
+		size_t histogram[256] = {};
+		for (size_t i = 0; i < count; ++i)
+			++histogram[mItems[src[i].item].group];
+
+		if (histogram[mItems[src[0].item].group] != count)
+		{
+			size_t offset = 0;
+			for (int digit = 0; digit < 256; ++digit)
+			{
+				size_t bucketSize = histogram[digit];
+				histogram[digit] = offset;
+				offset += bucketSize;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+				dst[histogram[mItems[src[i].item].group]++] = src[i];
+
+			std::swap(src, dst);
+		}
+	}
+
+	// An odd number of executed passes leaves the result in the scratch buffer
+	if (src != mEntries.data())
+		mEntries.swap(mScratch);
+}
+
+///////////////////////////////////////////////////
+//	Execute(RingBuffer&, ...)
+//
+//	ring: dynamic buffer of the current frame
+//	beginGroup, endGroup: optional, called around
+//	the runs of each group
+//
+//	Write the instance stream and the indirect
+//	commands into the ring, then issue one
+//	multi-draw per run of commands that share
+//	program, VAO and texture
+///////////////////////////////////////////////////
+void RenderQueue::Execute(RingBuffer& ring, const GroupCallback& beginGroup, const GroupCallback& endGroup)
+{
+	mStats = Stats();
+
+	if (mEntries.empty())
+		return;
+
+	// Out of ring space: the ring grows next frame, skip drawing this one
+	if (!BuildCommands(ring))
+		return;
+
+	GLuint currentProgram = NO_STATE;
+	GLuint currentVao = NO_STATE;
+	GLuint currentTexture = NO_STATE;
+	bool inGroup = false;
+	uint8_t currentGroup = 0;
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ring.id);
+
+	size_t runStart = 0;
+	while (runStart < mCommandCount)
+	{
+		const DrawItem& item = mItems[mEntries[mCommandItems[runStart]].item];
+
+		// Extend the run over every following command drawn with the same state
+		size_t runEnd = runStart + 1;
+		while (runEnd < mCommandCount && SameState(item, mItems[mEntries[mCommandItems[runEnd]].item]))
+			++runEnd;
+
+		if (!inGroup || item.group != currentGroup)
+		{
+			if (inGroup && endGroup)
+				endGroup(currentGroup);
+			if (beginGroup)
+				beginGroup(item.group);
+			currentGroup = item.group;
+			inGroup = true;
+		}
+
+		if (item.program != currentProgram)
+		{
+			glUseProgram(item.program);
+			currentProgram = item.program;
+			++mStats.programChanges;
+		}
+
+		if (item.vao != currentVao)
+		{
+			AttachInstanceStream(item.vao, ring);
+			glBindVertexArray(item.vao);
+			currentVao = item.vao;
+			++mStats.vaoChanges;
+		}
+
+		if (item.texture != currentTexture)
+		{
+			glBindTexture(GL_TEXTURE_2D_ARRAY, item.texture);
+			currentTexture = item.texture;
+			++mStats.textureChanges;
+		}
+
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			(void*)(mCommandOffset + sizeof(DrawElementsIndirectCommand) * runStart), (GLsizei)(runEnd - runStart), 0);
+
+		++mStats.draws;
+		mStats.commands += (unsigned int)(runEnd - runStart);
+
+		runStart = runEnd;
+	}
+
+	if (inGroup && endGroup)
+		endGroup(currentGroup);
+
+	mStats.instances = (unsigned int)mEntries.size();
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	// Deactivate the Vertex Array Object
+	glBindVertexArray(0);
+}
+
+///////////////////////////////////////////////////
+//	BuildCommands(RingBuffer&)
+//
+//	ring: dynamic buffer of the current frame
+//
+//	Collapse every run of items sharing state and
+//	mesh range into one instanced command, then
+//	write the instance data in sorted order and the
+//	commands straight into mapped ring memory
+///////////////////////////////////////////////////
+bool RenderQueue::BuildCommands(RingBuffer& ring)
+{
+	mCommandItems.clear();
+	for (size_t i = 0; i < mEntries.size(); ++i)
+	{
+		if (i == 0 || !SameCommand(mItems[mEntries[mCommandItems.back()].item], mItems[mEntries[i].item]))
+			mCommandItems.push_back((uint32_t)i);
+	}
+	mCommandCount = mCommandItems.size();
+
+	RingBuffer::Allocation instances = ring.Allocate(mEntries.size() * sizeof(GPUInstance), sizeof(GPUInstance));
+	RingBuffer::Allocation commands = ring.Allocate(mCommandCount * sizeof(DrawElementsIndirectCommand), sizeof(GLuint));
+	if (!instances.IsValid() || !commands.IsValid())
+		return false;
+
+	// The instance attributes read from offset 0 of the ring
+	GLuint instanceBase = (GLuint)(instances.offset / sizeof(GPUInstance));
+
+	GPUInstance* instanceData = (GPUInstance*)instances.data;
+	for (size_t i = 0; i < mEntries.size(); ++i)
+	{
+		const DrawItem& item = mItems[mEntries[i].item];
+		instanceData[i].transformIndex = item.transformIndex;
+		instanceData[i].materialIndex = item.materialIndex;
+	}
+
+	DrawElementsIndirectCommand* commandData = (DrawElementsIndirectCommand*)commands.data;
+	for (size_t c = 0; c < mCommandCount; ++c)
+	{
+		size_t first = mCommandItems[c];
+		size_t last = c + 1 < mCommandCount ? mCommandItems[c + 1] : mEntries.size();
+		const DrawItem& item = mItems[mEntries[first].item];
+
+		DrawElementsIndirectCommand command;
+		command.count = (GLuint)item.count;
+		command.instanceCount = (GLuint)(last - first);
+		command.firstIndex = item.firstIndex;
+		command.baseVertex = item.baseVertex;
+		command.baseInstance = instanceBase + (GLuint)first;
+		commandData[c] = command;
+	}
+
+	mCommandOffset = commands.offset;
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	AttachInstanceStream(GLuint, const RingBuffer&)
+//
+//	vao: mesh vertex array object
+//	ring: ring buffer holding the instance stream
+//
+//	Point the per-instance attributes of a mesh VAO
+//	at offset 0 of the ring. Done once per VAO, and
+//	again if the ring was reallocated: a grown store
+//	often comes back under the same name, so its
+//	generation is compared as well.
+///////////////////////////////////////////////////
+void RenderQueue::AttachInstanceStream(GLuint vao, const RingBuffer& ring)
+{
+	if (ring.id != mInstanceSource || ring.Generation() != mInstanceGeneration)
+	{
+		mInstancedVaos.clear();
+		mInstanceSource = ring.id;
+		mInstanceGeneration = ring.Generation();
+	}
+
+	GLuint buffer = ring.id;
+
+	if (!mInstancedVaos.insert(vao).second)
+		return;
+
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	const GLsizei stride = sizeof(GPUInstance);
+
+	glVertexAttribIPointer(INSTANCE_TRANSFORM_LOCATION, 1, GL_UNSIGNED_INT, stride, (void*)offsetof(GPUInstance, transformIndex));
+	glVertexAttribDivisor(INSTANCE_TRANSFORM_LOCATION, 1);
+	glEnableVertexAttribArray(INSTANCE_TRANSFORM_LOCATION);
+
+	glVertexAttribIPointer(INSTANCE_MATERIAL_LOCATION, 1, GL_UNSIGNED_INT, stride, (void*)offsetof(GPUInstance, materialIndex));
+	glVertexAttribDivisor(INSTANCE_MATERIAL_LOCATION, 1);
+	glEnableVertexAttribArray(INSTANCE_MATERIAL_LOCATION);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool RenderQueue::SameCommand(const DrawItem& a, const DrawItem& b)
+{
+	return SameState(a, b) &&
+		a.firstIndex == b.firstIndex && a.count == b.count && a.baseVertex == b.baseVertex;
+}
+
+bool RenderQueue::SameState(const DrawItem& a, const DrawItem& b)
+{
+	return a.program == b.program && a.vao == b.vao && a.texture == b.texture && a.group == b.group;
+}
+
+///////////////////////////////////////////////////
+//	Slot(...)
+//
+//	Map a handle to a small, stable slot number
+//	that fits in its field of the sort key
+///////////////////////////////////////////////////
+uint32_t RenderQueue::Slot(std::unordered_map<uint64_t, uint32_t>& slots, uint64_t handle, uint32_t maxSlots)
+{
+	auto it = slots.find(handle);
+	if (it != slots.end())
+		return it->second;
+
+	// Past the field width everything shares the last slot; only sort quality suffers
+	uint32_t slot = std::min((uint32_t)slots.size(), maxSlots - 1);
+	slots[handle] = slot;
+	return slot;
+}
@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderQueue.h
+// ========
+// collects draw items for a frame, sorts them by a packed 64-bit state key
+// and submits them as multi-draw indirect commands with as few GL state
+// changes as possible
+//
+// Key layout, most significant first:
+//	[63..56] program slot   (8 bits)
+//	[55..44] VAO slot       (12 bits)
+//	[43..32] texture array slot (12 bits)
+//	[31..24] mesh range slot (8 bits)
+//	[23..0]  view depth     (24 bits, front to back)
+//
+// Items whose program, VAO, texture and mesh range match end up adjacent
+// after sorting and become one instanced indirect command. All commands
+// that share program, VAO and texture are then issued together with a
+// single glMultiDrawElementsIndirect call. Textures are layers of 2D array
+// textures picked by the material in the shader, so with the mesh geometry
+// pooled behind one VAO and the scene's textures sharing one array, the
+// whole opaque scene is one run. The model transform index and material
+// index of every item travel in the per-instance vertex stream (see
+// GPUInstance in sceneData.h).
+//
+// The instance stream and the indirect commands are written straight into
+// the frame's section of a persistently mapped RingBuffer. The instance
+// attributes of every VAO point at offset 0 of the ring; each command's
+// baseInstance is biased by the frame's offset instead of re-pointing them.
+//
+// With grouping enabled, items also carry a group id (e.g. a scene section).
+// Sort() then orders by group first, runs never cross a group boundary, and
+// Execute() calls back around every group so its work can be measured. This
+// costs batching and is meant for profiling only.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "meshes.h"
+#include "ringBuffer.h"
+#include "sceneData.h"
+
+class RenderQueue
+{
+public:
+	// One draw: a range of the pooled index buffer with its material and transform
+	struct DrawItem
+	{
+		GLuint program;
+		GLuint vao;
+		GLuint texture;         // GL_TEXTURE_2D_ARRAY holding the material's layer
+		GLuint materialIndex;
+		GLuint firstIndex;      // Absolute offset in the pooled index buffer
+		GLsizei count;          // Number of indices
+		GLint baseVertex;       // Added to every index by the GPU
+		GLuint transformIndex;  // Entry of the transform store
+		uint8_t group;          // 0 unless grouping is enabled
+	};
+
+	// Work issued by the last Execute()
+	struct Stats
+	{
+		unsigned int draws;             // glMultiDrawElementsIndirect calls
+		unsigned int commands;          // Indirect commands across those calls
+		unsigned int instances;         // Items drawn
+		unsigned int programChanges;
+		unsigned int vaoChanges;
+		unsigned int textureChanges;
+	};
+
+	// Receives the group id of the run of commands about to start or just ended
+	typedef std::function<void(uint8_t group)> GroupCallback;
+
+public:
+	void Clear();
+
+	// Queue one pooled mesh range. viewDepth is the distance from the camera, used
+	// to order items that share all other state front to back. group is ignored
+	// unless grouping is enabled.
+	void Submit(GLuint program, const Meshes::GLMesh& mesh, const Meshes::SubMesh& range,
+		GLuint materialIndex, GLuint texture, GLuint transformIndex, float viewDepth, uint8_t group = 0);
+
+	void Sort();
+	void Execute(RingBuffer& ring, const GroupCallback& beginGroup = GroupCallback(), const GroupCallback& endGroup = GroupCallback());
+
+	// Keep the items of each group together; takes effect from the next Submit()
+	void SetGrouping(bool enabled) { mGrouping = enabled; }
+	bool Grouping() const { return mGrouping; }
+
+	size_t Size() const { return mItems.size(); }
+	const Stats& LastStats() const { return mStats; }
+
+	// Far plane distance used to quantize the depth bits of the key
+	float depthRange = 100.0f;
+
+private:
+	struct SortEntry
+	{
+		uint64_t key;
+		uint32_t item;
+	};
+
+	// Layout consumed by glMultiDrawElementsIndirect
+	struct DrawElementsIndirectCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	bool BuildCommands(RingBuffer& ring);
+	void AttachInstanceStream(GLuint vao, const RingBuffer& ring);
+
+	static bool SameCommand(const DrawItem& a, const DrawItem& b);
+	static bool SameState(const DrawItem& a, const DrawItem& b);
+	static uint32_t Slot(std::unordered_map<uint64_t, uint32_t>& slots, uint64_t handle, uint32_t maxSlots);
+
+	std::vector<DrawItem> mItems;
+	std::vector<SortEntry> mEntries;
+	std::vector<SortEntry> mScratch;
+	std::vector<uint32_t> mCommandItems;    // First sorted entry of each command
+	size_t mCommandCount = 0;
+
+	// Where this frame's commands were written in the ring
+	GLintptr mCommandOffset = 0;
+
+	// VAOs whose instance attributes already point at the ring buffer's current store
+	GLuint mInstanceSource = 0;
+	unsigned int mInstanceGeneration = 0;
+	std::unordered_set<GLuint> mInstancedVaos;
+
+	// Stable handle -> compact slot mappings, kept across frames so keys do not shift
+	std::unordered_map<uint64_t, uint32_t> mProgramSlots;
+	std::unordered_map<uint64_t, uint32_t> mVaoSlots;
+	std::unordered_map<uint64_t, uint32_t> mTextureSlots;
+	std::unordered_map<uint64_t, uint32_t> mRangeSlots;
+
+	bool mGrouping = false;
+	Stats mStats = {};
+};
@@ -0,0 +1,184 @@
+///////////////////////////////////////////////////////////////////////////////
+// ringBuffer.cpp
+// ========
+// persistently mapped, fence-guarded ring buffer for per-frame dynamic data
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ringBuffer.h"
+#include "glResources.h"
+
+#include <iostream>
+
+namespace
+{
+	// Sections are kept a multiple of this, so every section starts aligned
+	// for any uniform, storage or vertex offset requirement
+	const GLsizeiptr SECTION_GRANULARITY = 256;
+
+	// Longest single wait on a fence before it is reported, in nanoseconds
+	const GLuint64 FENCE_TIMEOUT = 1000000000;
+}
+
+///////////////////////////////////////////////////
+//	Create(GLsizeiptr)
+//
+//	bytesPerFrame: size of each of the FRAME_COUNT sections
+//
+//	Allocate the immutable store and map it for the
+//	lifetime of the buffer
+///////////////////////////////////////////////////
+bool RingBuffer::Create(GLsizeiptr bytesPerFrame)
+{
+	mSection = 0;
+	mHead = 0;
+	mOverflow = 0;
+
+	return CreateStore(bytesPerFrame);
+}
+
+void RingBuffer::Destroy()
+{
+	for (int i = 0; i < FRAME_COUNT; ++i)
+		WaitForSection(i);
+
+	DestroyStore();
+}
+
+///////////////////////////////////////////////////
+//	BeginFrame()
+//
+//	Move to the next section, blocking only if the
+//	GPU has not finished reading it yet. If the last
+//	frame ran out of space, the store is doubled.
+///////////////////////////////////////////////////
+void RingBuffer::BeginFrame()
+{
+	if (mOverflow > 0)
+	{
+		GLsizeiptr needed = mSectionSize + mOverflow;
+		GLsizeiptr grown = mSectionSize * 2;
+		while (grown < needed)
+			grown *= 2;
+
+		// Every section may still be read, so drain them all before replacing the store
+		for (int i = 0; i < FRAME_COUNT; ++i)
+			WaitForSection(i);
+
+		DestroyStore();
+		CreateStore(grown);
+		++mGeneration;
+		mOverflow = 0;
+	}
+
+	mSection = (mSection + 1) % FRAME_COUNT;
+	mHead = 0;
+
+	WaitForSection(mSection);
+}
+
+void RingBuffer::EndFrame()
+{
+	mFences[mSection] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+///////////////////////////////////////////////////
+//	Allocate(GLsizeiptr, GLsizeiptr)
+//
+//	bytes: space needed
+//	alignment: required multiple of the buffer offset
+//
+//	Hand out the next aligned block of the current
+//	section
+///////////////////////////////////////////////////
+RingBuffer::Allocation RingBuffer::Allocate(GLsizeiptr bytes, GLsizeiptr alignment)
+{
+	Allocation allocation;
+
+	GLsizeiptr sectionStart = mSectionSize * mSection;
+	GLsizeiptr offset = sectionStart + mHead;
+	if (alignment > 1)
+		offset = (offset + alignment - 1) / alignment * alignment;
+
+	if (mMapped == nullptr || offset + bytes > sectionStart + mSectionSize)
+	{
+		mOverflow += bytes + alignment;
+		return allocation;
+	}
+
+	mHead = offset + bytes - sectionStart;
+
+	allocation.data = mMapped + offset;
+	allocation.offset = offset;
+	return allocation;
+}
+
+///////////////////////////////////////////////////
+//	CreateStore(GLsizeiptr)
+//
+//	Create the immutable buffer store for all the
+//	sections and keep it mapped
+///////////////////////////////////////////////////
+bool RingBuffer::CreateStore(GLsizeiptr bytesPerFrame)
+{
+	mSectionSize = (bytesPerFrame + SECTION_GRANULARITY - 1) / SECTION_GRANULARITY * SECTION_GRANULARITY;
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	id = CreateImmutableBuffer(mSectionSize * FRAME_COUNT, NULL, flags);
+	mMapped = (unsigned char*)MapBufferRange(id, 0, mSectionSize * FRAME_COUNT, flags);
+
+	if (mMapped == nullptr)
+	{
+		std::cout << "ERROR::RING_BUFFER::MAP_FAILED" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void RingBuffer::DestroyStore()
+{
+	if (id != 0)
+	{
+		if (mMapped != nullptr)
+			UnmapBuffer(id);
+		DeleteBuffer(id);
+	}
+
+	id = 0;
+	mMapped = nullptr;
+	mSectionSize = 0;
+}
+
+///////////////////////////////////////////////////
+//	WaitForSection(int)
+//
+//	Block until the GPU has consumed the commands
+//	that read a section, then drop its fence
+///////////////////////////////////////////////////
+void RingBuffer::WaitForSection(int section)
+{
+	GLsync fence = mFences[section];
+	if (fence == 0)
+		return;
+
+	// The first wait flushes so the fence is guaranteed to be signaled eventually
+	GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	for (;;)
+	{
+		GLenum result = glClientWaitSync(fence, waitFlags, FENCE_TIMEOUT);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+			break;
+		if (result == GL_WAIT_FAILED)
+		{
+			std::cout << "ERROR::RING_BUFFER::FENCE_WAIT_FAILED" << std::endl;
+			break;
+		}
+
+		std::cout << "WARNING::RING_BUFFER::FENCE_TIMEOUT" << std::endl;
+		waitFlags = 0;
+	}
+
+	glDeleteSync(fence);
+	mFences[section] = 0;
+}
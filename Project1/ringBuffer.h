@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+// ringBuffer.h
+// ========
+// persistently mapped, fence-guarded ring buffer for per-frame dynamic data
+//
+// The buffer store is split into FRAME_COUNT sections and mapped once with
+// GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT. Each frame writes straight
+// into its own section and binds the results by offset; a fence placed at
+// the end of the frame keeps the CPU from overwriting a section the GPU is
+// still reading. Nothing goes through glBufferData/glBufferSubData, so the
+// driver neither copies the data nor synchronizes implicitly.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+class RingBuffer
+{
+public:
+	// Sections in flight: one being written, up to two being read by the GPU
+	static const int FRAME_COUNT = 3;
+
+	// Space handed out for the current frame
+	struct Allocation
+	{
+		void* data = nullptr;       // Write-only pointer into the mapped store
+		GLintptr offset = 0;        // Offset of data from the start of the buffer
+
+		bool IsValid() const { return data != nullptr; }
+	};
+
+	GLuint id = 0;                  // Handle for the buffer object
+
+public:
+	bool Create(GLsizeiptr bytesPerFrame);
+	void Destroy();
+
+	// Wait until the GPU is done with the next section and start writing it
+	void BeginFrame();
+	// Fence the section written since BeginFrame()
+	void EndFrame();
+
+	// Reserve bytes in the current section at an offset that is a multiple of
+	// alignment. Returns an invalid allocation when the section is full; the
+	// ring then grows at the next BeginFrame().
+	Allocation Allocate(GLsizeiptr bytes, GLsizeiptr alignment);
+
+	GLsizeiptr BytesPerFrame() const { return mSectionSize; }
+	// Changes whenever the store is replaced; GL may reuse the same name for the new one
+	unsigned int Generation() const { return mGeneration; }
+	// Bytes handed out since BeginFrame(), alignment padding included
+	GLsizeiptr BytesUsed() const { return mHead; }
+
+private:
+	bool CreateStore(GLsizeiptr bytesPerFrame);
+	void DestroyStore();
+	void WaitForSection(int section);
+
+	GLsizeiptr mSectionSize = 0;
+	unsigned char* mMapped = nullptr;
+	GLsync mFences[FRAME_COUNT] = {};
+
+	int mSection = 0;
+	GLsizeiptr mHead = 0;               // Next free byte of the current section
+	GLsizeiptr mOverflow = 0;           // Bytes refused during the current frame
+	unsigned int mGeneration = 0;       // Stores created so far
+};
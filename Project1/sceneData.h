@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneData.h
+// ========
+// CPU mirrors of the std140 uniform blocks, the std430 storage blocks and
+// the per-instance vertex stream read by the surface shader
+//
+// Any change here must be made to the GLSL declarations in Source.cpp too;
+// the uniform block sizes are checked against shader reflection at startup.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+// Uniform block binding points shared by C++ and GLSL
+const GLuint FRAME_DATA_BINDING = 0;
+const GLuint MATERIAL_DATA_BINDING = 1;
+
+// Shader storage block binding points shared by C++ and GLSL
+const GLuint TRANSFORM_DATA_BINDING = 0;
+
+// Vertex attribute locations of the per-instance stream shared by C++ and GLSL
+const GLuint INSTANCE_TRANSFORM_LOCATION = 3;   // uint
+const GLuint INSTANCE_MATERIAL_LOCATION = 4;    // uint
+
+// Array sizes shared by C++ and GLSL
+const int MAX_LIGHTS = 2;
+const int MAX_MATERIALS = 16;
+
+// std140: vec4 aligned, 32 bytes
+struct GPULight
+{
+	glm::vec4 position;         // xyz: world position
+	glm::vec4 color;            // rgb: light color
+};
+
+// std140 "FrameData" block, written once per frame
+struct GPUFrameData
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 viewPosition;     // xyz: camera position
+	glm::vec4 ambientColor;     // rgb: ambient light color
+	GPULight lights[MAX_LIGHTS];
+};
+
+// std140 "Material" struct, one entry of the "MaterialData" block
+struct GPUMaterial
+{
+	glm::vec4 objectColor;      // Used when the material has no texture
+	glm::vec2 uvScale;
+	float ambientStrength;
+	GLint textureLayer;         // Layer of the bound texture array, -1 for none
+	glm::vec2 specularIntensity;    // Per light
+	glm::vec2 highlightSize;        // Per light
+};
+
+// std140 "MaterialData" block, written at load time and again as textures stream in
+struct GPUMaterialData
+{
+	GPUMaterial materials[MAX_MATERIALS];
+};
+
+// std430 "Transform" struct, one entry of the "TransformData" storage block
+struct GPUTransform
+{
+	glm::mat4 world;
+	glm::mat4 mvp;              // projection * view * world
+	glm::vec4 normalMatrix[3];  // mat3 columns, each padded to a vec4
+};
+
+// Per-instance vertex stream entry, read with a divisor of 1
+struct GPUInstance
+{
+	GLuint transformIndex;      // Entry of the TransformData block
+	GLuint materialIndex;       // Entry of the MaterialData block
+};
+
+static_assert(sizeof(GPULight) == 32, "GPULight must match the std140 Light layout");
+static_assert(sizeof(GPUFrameData) == 160 + 32 * MAX_LIGHTS, "GPUFrameData must match the std140 FrameData layout");
+static_assert(sizeof(GPUMaterial) == 48, "GPUMaterial must match the std140 Material layout");
+static_assert(sizeof(GPUTransform) == 176, "GPUTransform must match the std430 Transform layout");
+static_assert(sizeof(GPUInstance) == 8, "GPUInstance must match the instance attribute layout");
@@ -0,0 +1,194 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderProgram.cpp
+// ========
+// linked GLSL program with uniform reflection captured once at link time
+///////////////////////////////////////////////////////////////////////////////
+
+#include "shaderProgram.h"
+#include "gpuMemory.h"
+
+#include <iostream>
+#include <vector>
+
+///////////////////////////////////////////////////
+//	Link(GLuint, GLuint)
+//
+//	vertexShaderId: compiled vertex shader object
+//	fragmentShaderId: compiled fragment shader object
+//
+//	Create the program object, link the two shader
+//	stages into it and reflect the active uniforms
+///////////////////////////////////////////////////
+bool ShaderProgram::Link(GLuint vertexShaderId, GLuint fragmentShaderId)
+{
+	int success = 0;
+	char infoLog[512];
+
+	// Create a Shader program object.
+	id = glCreateProgram();
+
+	// Attached compiled shaders to the shader program
+	glAttachShader(id, vertexShaderId);
+	glAttachShader(id, fragmentShaderId);
+
+	// Links the shader program
+	glLinkProgram(id);
+	// Check for linking errors
+	glGetProgramiv(id, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glGetProgramInfoLog(id, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+
+		// Deleting the program also detaches the stages; id 0 tells callers nothing was linked
+		glDeleteProgram(id);
+		id = 0;
+		return false;
+	}
+
+	// The stages are no longer needed once the program is linked
+	glDetachShader(id, vertexShaderId);
+	glDetachShader(id, fragmentShaderId);
+
+	// The linked binary is the closest measure of what the program occupies
+	GLint binaryLength = 0;
+	glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	GpuMemory::Track(GpuMemory::CATEGORY_PROGRAM, id, binaryLength);
+
+	Reflect();
+
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	Destroy()
+//
+//	Release the program object and its reflection data
+///////////////////////////////////////////////////
+void ShaderProgram::Destroy()
+{
+	if (id != 0)
+	{
+		GpuMemory::Release(GpuMemory::CATEGORY_PROGRAM, id);
+		glDeleteProgram(id);
+	}
+
+	id = 0;
+	mUniforms.clear();
+	mUniformBlocks.clear();
+}
+
+///////////////////////////////////////////////////
+//	Reflect()
+//
+//	Walk the GL_UNIFORM and GL_UNIFORM_BLOCK program
+//	interfaces once and cache everything the render
+//	loop needs to address a uniform
+///////////////////////////////////////////////////
+void ShaderProgram::Reflect()
+{
+	mUniforms.clear();
+	mUniformBlocks.clear();
+
+	std::vector<char> name;
+	GLint maxNameLength = 0;
+
+	// Uniform blocks
+	GLint blockCount = 0;
+	glGetProgramInterfaceiv(id, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &blockCount);
+	glGetProgramInterfaceiv(id, GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH, &maxNameLength);
+	name.resize(maxNameLength > 0 ? maxNameLength : 1);
+
+	const GLenum blockProps[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+	for (GLint i = 0; i < blockCount; ++i)
+	{
+		GLint values[2] = { 0, 0 };
+		glGetProgramResourceiv(id, GL_UNIFORM_BLOCK, i, 2, blockProps, 2, NULL, values);
+		glGetProgramResourceName(id, GL_UNIFORM_BLOCK, i, (GLsizei)name.size(), NULL, name.data());
+
+		UniformBlockInfo info;
+		info.index = (GLuint)i;
+		info.binding = values[0];
+		info.dataSize = values[1];
+		mUniformBlocks[name.data()] = info;
+	}
+
+	// Uniforms, both in the default block and inside uniform blocks
+	GLint uniformCount = 0;
+	glGetProgramInterfaceiv(id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+	glGetProgramInterfaceiv(id, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+	name.resize(maxNameLength > 0 ? maxNameLength : 1);
+
+	const GLenum uniformProps[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX, GL_OFFSET };
+	for (GLint i = 0; i < uniformCount; ++i)
+	{
+		GLint values[5] = { 0, 0, -1, -1, -1 };
+		glGetProgramResourceiv(id, GL_UNIFORM, i, 5, uniformProps, 5, NULL, values);
+		glGetProgramResourceName(id, GL_UNIFORM, i, (GLsizei)name.size(), NULL, name.data());
+
+		UniformInfo info;
+		info.type = (GLenum)values[0];
+		info.arraySize = values[1];
+		info.location = values[2];
+		info.blockIndex = values[3];
+		info.offset = values[4];
+
+		std::string uniformName = name.data();
+		mUniforms[uniformName] = info;
+
+		// Arrays are reported as "name[0]"; also register the bare name
+		const std::string arraySuffix = "[0]";
+		if (uniformName.size() > arraySuffix.size() &&
+			uniformName.compare(uniformName.size() - arraySuffix.size(), arraySuffix.size(), arraySuffix) == 0)
+		{
+			mUniforms[uniformName.substr(0, uniformName.size() - arraySuffix.size())] = info;
+		}
+	}
+}
+
+///////////////////////////////////////////////////
+//	GetSampler(const char*)
+//
+//	name: sampler uniform name
+//
+//	Resolve any sampler type as an integer texture unit handle
+///////////////////////////////////////////////////
+Uniform<int> ShaderProgram::GetSampler(const char* name) const
+{
+	Uniform<int> handle;
+	const UniformInfo* info = FindUniform(name);
+	if (info != nullptr && info->location >= 0 &&
+		(info->type == GL_SAMPLER_2D || info->type == GL_SAMPLER_2D_ARRAY || info->type == GL_SAMPLER_CUBE))
+		handle.location = info->location;
+	else
+		ReportUnresolved(name, info);
+	return handle;
+}
+
+const ShaderProgram::UniformInfo* ShaderProgram::FindUniform(const char* name) const
+{
+	auto it = mUniforms.find(name);
+	return it != mUniforms.end() ? &it->second : nullptr;
+}
+
+const ShaderProgram::UniformBlockInfo* ShaderProgram::FindUniformBlock(const char* name) const
+{
+	auto it = mUniformBlocks.find(name);
+	return it != mUniformBlocks.end() ? &it->second : nullptr;
+}
+
+bool ShaderProgram::IsCompatible(GLenum reflected, GLenum requested)
+{
+	// bool uniforms may be written through glUniform1i
+	if (requested == GL_INT && reflected == GL_BOOL)
+		return true;
+	return reflected == requested;
+}
+
+void ShaderProgram::ReportUnresolved(const char* name, const UniformInfo* info)
+{
+	if (info == nullptr)
+		std::cout << "WARNING::SHADER::UNIFORM_NOT_ACTIVE " << name << std::endl;
+	else
+		std::cout << "WARNING::SHADER::UNIFORM_TYPE_MISMATCH " << name << std::endl;
+}
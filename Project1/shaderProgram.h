@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderProgram.h
+// ========
+// linked GLSL program with uniform reflection captured once at link time
+//
+// Every active uniform and uniform block is read through the program
+// interface query API right after linking, so the render loop can work
+// with pre-resolved, typed handles instead of calling glGetUniformLocation
+// with a string every frame.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <string>
+#include <unordered_map>
+
+// Pre-resolved handle for a uniform in the default block. The template
+// parameter is the C++ type the uniform is written with.
+template <typename T>
+struct Uniform
+{
+	GLint location = -1;
+
+	bool IsValid() const { return location >= 0; }
+};
+
+// Maps a C++ uniform type to the GLSL type reported by reflection
+template <typename T> struct UniformGLType;
+template <> struct UniformGLType<bool>      { static const GLenum value = GL_BOOL; };
+template <> struct UniformGLType<int>       { static const GLenum value = GL_INT; };
+template <> struct UniformGLType<GLuint>    { static const GLenum value = GL_UNSIGNED_INT; };
+template <> struct UniformGLType<float>     { static const GLenum value = GL_FLOAT; };
+template <> struct UniformGLType<glm::vec2> { static const GLenum value = GL_FLOAT_VEC2; };
+template <> struct UniformGLType<glm::vec3> { static const GLenum value = GL_FLOAT_VEC3; };
+template <> struct UniformGLType<glm::vec4> { static const GLenum value = GL_FLOAT_VEC4; };
+template <> struct UniformGLType<glm::mat3> { static const GLenum value = GL_FLOAT_MAT3; };
+template <> struct UniformGLType<glm::mat4> { static const GLenum value = GL_FLOAT_MAT4; };
+
+class ShaderProgram
+{
+public:
+	// Reflected description of one active uniform
+	struct UniformInfo
+	{
+		GLenum type;        // GLSL type (GL_FLOAT_VEC3, GL_SAMPLER_2D, ...)
+		GLint arraySize;    // Number of array elements, 1 for non-arrays
+		GLint location;     // Default block location, -1 for block members
+		GLint blockIndex;   // Owning uniform block, -1 for the default block
+		GLint offset;       // Byte offset inside the owning block
+	};
+
+	// Reflected description of one active uniform block
+	struct UniformBlockInfo
+	{
+		GLuint index;       // Block index inside the program
+		GLint binding;      // Buffer binding point the block reads from
+		GLint dataSize;     // Minimum buffer size required by the block
+	};
+
+	GLuint id = 0;          // Handle for the linked program object
+
+public:
+	bool Link(GLuint vertexShaderId, GLuint fragmentShaderId);
+	void Destroy();
+
+	// Resolve a typed uniform handle. Only meant to be called at load time;
+	// a missing uniform or a type mismatch yields an invalid handle.
+	template <typename T>
+	Uniform<T> GetUniform(const char* name) const
+	{
+		Uniform<T> handle;
+		const UniformInfo* info = FindUniform(name);
+		if (info != nullptr && IsCompatible(info->type, UniformGLType<T>::value))
+			handle.location = info->location;
+		else
+			ReportUnresolved(name, info);
+		return handle;
+	}
+
+	// Resolve a sampler uniform (any sampler type) as an integer unit handle
+	Uniform<int> GetSampler(const char* name) const;
+
+	const UniformInfo* FindUniform(const char* name) const;
+	const UniformBlockInfo* FindUniformBlock(const char* name) const;
+
+	const std::unordered_map<std::string, UniformInfo>& Uniforms() const { return mUniforms; }
+	const std::unordered_map<std::string, UniformBlockInfo>& UniformBlocks() const { return mUniformBlocks; }
+
+private:
+	void Reflect();
+
+	static bool IsCompatible(GLenum reflected, GLenum requested);
+	static void ReportUnresolved(const char* name, const UniformInfo* info);
+
+	std::unordered_map<std::string, UniformInfo> mUniforms;
+	std::unordered_map<std::string, UniformBlockInfo> mUniformBlocks;
+};
+
+// Typed uniform writes for the currently bound program
+inline void SetUniform(Uniform<bool> u, bool value)                { glUniform1i(u.location, value ? 1 : 0); }
+inline void SetUniform(Uniform<int> u, int value)                  { glUniform1i(u.location, value); }
+inline void SetUniform(Uniform<GLuint> u, GLuint value)            { glUniform1ui(u.location, value); }
+inline void SetUniform(Uniform<float> u, float value)              { glUniform1f(u.location, value); }
+inline void SetUniform(Uniform<glm::vec2> u, const glm::vec2& v)   { glUniform2f(u.location, v.x, v.y); }
+inline void SetUniform(Uniform<glm::vec3> u, const glm::vec3& v)   { glUniform3f(u.location, v.x, v.y, v.z); }
+inline void SetUniform(Uniform<glm::vec4> u, const glm::vec4& v)   { glUniform4f(u.location, v.x, v.y, v.z, v.w); }
+inline void SetUniform(Uniform<glm::mat3> u, const glm::mat3& m)   { glUniformMatrix3fv(u.location, 1, GL_FALSE, glm::value_ptr(m)); }
+inline void SetUniform(Uniform<glm::mat4> u, const glm::mat4& m)   { glUniformMatrix4fv(u.location, 1, GL_FALSE, glm::value_ptr(m)); }
@@ -0,0 +1,214 @@
+///////////////////////////////////////////////////////////////////////////////
+// startupTimeline.cpp
+// ========
+// monotonic timeline of the startup phases, from launch to the first frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "startupTimeline.h"
+
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	// Index returned for phases begun once startup is over
+	const size_t NO_PHASE = (size_t)-1;
+
+	// Phase names are labels and asset names file paths: escape what JSON requires
+	std::string EscapeJson(const std::string& text)
+	{
+		std::string escaped;
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			if ((unsigned char)c >= 0x20)
+				escaped += c;
+		}
+		return escaped;
+	}
+}
+
+StartupTimeline::StartupTimeline()
+	: mLaunch(std::chrono::steady_clock::now())
+{
+}
+
+double StartupTimeline::NowMs() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mLaunch).count();
+}
+
+size_t StartupTimeline::AddAsset(const char* name)
+{
+	mAssets.push_back({ name, -1.0, -1.0, -1.0, false });
+	return mAssets.size() - 1;
+}
+
+///////////////////////////////////////////////////
+//	SetAssetLoad(size_t, double, double, bool)
+//
+//	index: value returned by AddAsset
+//	startMs, endMs: NowMs() around the load
+//	failed: the asset will never be ready
+//
+//	Record the load of an asset, on the main thread
+//	once the worker has handed it over
+///////////////////////////////////////////////////
+void StartupTimeline::SetAssetLoad(size_t index, double startMs, double endMs, bool failed)
+{
+	if (index >= mAssets.size())
+		return;
+
+	mAssets[index].loadStartMs = startMs;
+	mAssets[index].loadEndMs = endMs;
+	mAssets[index].failed = failed;
+}
+
+void StartupTimeline::MarkAssetReady(size_t index)
+{
+	if (index < mAssets.size() && mAssets[index].readyMs < 0.0)
+		mAssets[index].readyMs = NowMs();
+}
+
+bool StartupTimeline::AssetsSettled() const
+{
+	for (const Asset& asset : mAssets)
+	{
+		if (!asset.failed && asset.readyMs < 0.0)
+			return false;
+	}
+	return true;
+}
+
+size_t StartupTimeline::BeginPhase(const char* name)
+{
+	if (IsComplete())
+		return NO_PHASE;
+
+	mPhases.push_back({ name, (int)mOpen.size(), NowMs(), -1.0 });
+	mOpen.push_back(mPhases.size() - 1);
+	return mPhases.size() - 1;
+}
+
+///////////////////////////////////////////////////
+//	EndPhase(size_t)
+//
+//	index: value returned by BeginPhase
+//
+//	Close a phase, and any phase opened inside it
+//	that was left open
+///////////////////////////////////////////////////
+void StartupTimeline::EndPhase(size_t index)
+{
+	if (index == NO_PHASE || index >= mPhases.size() || mPhases[index].endMs >= 0.0)
+		return;
+
+	double now = NowMs();
+	while (!mOpen.empty())
+	{
+		size_t open = mOpen.back();
+		mOpen.pop_back();
+		mPhases[open].endMs = now;
+		if (open == index)
+			break;
+	}
+}
+
+void StartupTimeline::MarkFirstFrame()
+{
+	if (IsComplete())
+		return;
+
+	if (!mOpen.empty())
+		EndPhase(mOpen.front());
+
+	mFirstFrameMs = NowMs();
+}
+
+void StartupTimeline::Print() const
+{
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "INFO: Startup, " << mFirstFrameMs << " ms to the first frame:" << std::endl;
+
+	for (const Phase& phase : mPhases)
+	{
+		std::string label = std::string(2 + 2 * phase.depth, ' ') + phase.name;
+		std::cout << std::left << std::setw(56) << label << std::right
+			<< std::setw(10) << phase.endMs - phase.startMs << " ms   (at " << phase.startMs << " ms)" << std::endl;
+	}
+
+	std::cout << std::defaultfloat;
+}
+
+void StartupTimeline::PrintAssets() const
+{
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "INFO: Startup assets:" << std::endl;
+
+	for (const Asset& asset : mAssets)
+	{
+		std::cout << "  " << std::left << std::setw(54) << asset.name << std::right;
+		if (asset.loadStartMs >= 0.0)
+			std::cout << std::setw(10) << asset.loadEndMs - asset.loadStartMs << " ms   (at " << asset.loadStartMs << " ms)";
+		else
+			std::cout << std::setw(10) << "-" << "   (still loading)";
+
+		if (asset.readyMs >= 0.0)
+			std::cout << ", ready at " << asset.readyMs << " ms";
+		else if (asset.failed)
+			std::cout << ", failed";
+		else
+			std::cout << ", not ready";
+		std::cout << std::endl;
+	}
+
+	std::cout << std::defaultfloat;
+}
+
+bool StartupTimeline::WriteJson(const char* path, double budgetMs) const
+{
+	FILE* file = fopen(path, "w");
+	if (!file)
+	{
+		std::cout << "ERROR::STARTUP::CANNOT_WRITE " << path << std::endl;
+		return false;
+	}
+
+	fprintf(file, "{\n  \"time_to_first_frame_ms\": %.3f,\n", mFirstFrameMs);
+	if (budgetMs > 0.0)
+		fprintf(file, "  \"budget_ms\": %.3f,\n  \"over_budget\": %s,\n", budgetMs, mFirstFrameMs > budgetMs ? "true" : "false");
+	fprintf(file, "  \"phases\": [\n");
+
+	for (size_t i = 0; i < mPhases.size(); ++i)
+	{
+		const Phase& phase = mPhases[i];
+		fprintf(file, "    { \"name\": \"%s\", \"depth\": %d, \"start_ms\": %.3f, \"duration_ms\": %.3f }%s\n",
+			EscapeJson(phase.name).c_str(), phase.depth, phase.startMs, phase.endMs - phase.startMs,
+			i + 1 < mPhases.size() ? "," : "");
+	}
+
+	fprintf(file, "  ],\n  \"assets\": [\n");
+
+	// Times of an asset not loaded or not ready yet are null
+	for (size_t i = 0; i < mAssets.size(); ++i)
+	{
+		const Asset& asset = mAssets[i];
+		char load[64], ready[32] = "null";
+		if (asset.loadStartMs >= 0.0)
+			snprintf(load, sizeof(load), "%.3f, \"load_ms\": %.3f", asset.loadStartMs, asset.loadEndMs - asset.loadStartMs);
+		else
+			snprintf(load, sizeof(load), "null, \"load_ms\": null");
+		if (asset.readyMs >= 0.0)
+			snprintf(ready, sizeof(ready), "%.3f", asset.readyMs);
+
+		fprintf(file, "    { \"name\": \"%s\", \"load_start_ms\": %s, \"ready_ms\": %s, \"failed\": %s }%s\n",
+			EscapeJson(asset.name).c_str(), load, ready, asset.failed ? "true" : "false",
+			i + 1 < mAssets.size() ? "," : "");
+	}
+
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+	return true;
+}
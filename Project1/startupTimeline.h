@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// startupTimeline.h
+// ========
+// monotonic timeline of the startup phases, from launch to the first frame
+//
+// The timeline starts when it is constructed; as a global that is during
+// static initialization, before main() runs. Phases may nest (Initialize
+// holds CreateContext and glewInit) and are kept in the order they began.
+// MarkFirstFrame() closes every phase still open and fixes the cold-start
+// endpoint; phases begun after it are ignored.
+//
+// Assets loaded in the background are kept apart from the phases: each has
+// the time its load took on a worker and the time the renderer started
+// using it, which may well be after the first frame.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class StartupTimeline
+{
+public:
+	struct Phase
+	{
+		std::string name;
+		int depth;                  // Number of enclosing phases
+		double startMs;             // Since launch
+		double endMs;               // Negative while the phase is open
+	};
+
+	struct Asset
+	{
+		std::string name;
+		double loadStartMs;         // Since launch; negative until the load is recorded
+		double loadEndMs;
+		double readyMs;             // Since launch; negative until the renderer uses it
+		bool failed;
+	};
+
+public:
+	StartupTimeline();
+
+	// Open a phase inside the innermost open one; returns its index
+	size_t BeginPhase(const char* name);
+	void EndPhase(size_t index);
+
+	// The first frame has been presented: startup is over
+	void MarkFirstFrame();
+
+	bool IsComplete() const { return mFirstFrameMs >= 0.0; }
+	double TimeToFirstFrameMs() const { return mFirstFrameMs; }
+	const std::vector<Phase>& Phases() const { return mPhases; }
+
+	// Milliseconds since launch; safe to call from any thread, to time work done off the main thread
+	double NowMs() const;
+
+	// Track an asset loaded in the background; returns its index
+	size_t AddAsset(const char* name);
+	void SetAssetLoad(size_t index, double startMs, double endMs, bool failed);
+	void MarkAssetReady(size_t index);
+
+	// Every asset is in use, or failed
+	bool AssetsSettled() const;
+	const std::vector<Asset>& Assets() const { return mAssets; }
+
+	// Print the phases as an indented table
+	void Print() const;
+
+	// Print the assets, with their load and ready times
+	void PrintAssets() const;
+
+	// Write the phases, the assets and the time to first frame as JSON; budgetMs 0 is omitted
+	bool WriteJson(const char* path, double budgetMs) const;
+
+private:
+	std::chrono::steady_clock::time_point mLaunch;
+	std::vector<Phase> mPhases;
+	std::vector<Asset> mAssets;
+	std::vector<size_t> mOpen;      // Indices of the open phases, innermost last
+	double mFirstFrameMs = -1.0;
+};
+
+// Times the enclosing C++ scope as a startup phase
+class StartupPhase
+{
+public:
+	StartupPhase(StartupTimeline& timeline, const char* name) : mTimeline(timeline), mIndex(timeline.BeginPhase(name)) {}
+	~StartupPhase() { mTimeline.EndPhase(mIndex); }
+
+	StartupPhase(const StartupPhase&) = delete;
+	StartupPhase& operator=(const StartupPhase&) = delete;
+
+private:
+	StartupTimeline& mTimeline;
+	size_t mIndex;
+};
@@ -0,0 +1,248 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureCache.cpp
+// ========
+// on-disk cache of decoded textures with their full mip chain
+///////////////////////////////////////////////////////////////////////////////
+
+#include "textureCache.h"
+#include "imageUtils.h"
+#include "cpuProfiler.h"
+
+#include <stb-master/stb_image.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	const char MAGIC[4] = { 'T', 'E', 'X', 'C' };
+	const uint32_t VERSION = 2;
+
+	// Start of a cache file; the levels follow, level 0 first
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;        // Of the image file's bytes
+		uint32_t width;             // Level 0, after scaling to the layer size
+		uint32_t height;
+		uint32_t channels;
+		uint32_t levelCount;
+	};
+
+	// 64-bit FNV-1a
+	uint64_t HashBytes(const unsigned char* data, size_t size)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	bool ReadFile(const char* path, std::vector<unsigned char>& bytes)
+	{
+		FILE* file = fopen(path, "rb");
+		if (!file)
+			return false;
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		bool read = size > 0;
+		if (read)
+		{
+			bytes.resize((size_t)size);
+			read = fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+		}
+		fclose(file);
+		return read;
+	}
+
+	// Place every level of the texture's chain from offset on; returns the end of the last one
+	size_t LayOutLevels(CachedTexture& texture, int channels, size_t offset)
+	{
+		texture.levels.clear();
+		for (GLsizei level = 0; ; ++level)
+		{
+			GLsizei width = std::max(1, texture.width >> level);
+			GLsizei height = std::max(1, texture.height >> level);
+			size_t size = (size_t)width * height * channels;
+			texture.levels.push_back({ offset, size });
+			offset += size;
+
+			if (width == 1 && height == 1)
+				return offset;
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	MapEntry(const std::string&, uint64_t, GLsizei, CachedTexture&)
+	//
+	//	Map a cache file and check it was built from
+	//	the image with this hash, at this size; false
+	//	on a miss
+	///////////////////////////////////////////////////
+	bool MapEntry(const std::string& cachePath, uint64_t sourceHash, GLsizei size, CachedTexture& texture)
+	{
+		if (!texture.file.Open(cachePath.c_str()))
+			return false;
+
+		Header header;
+		bool valid = texture.file.Size() >= sizeof(Header);
+		if (valid)
+		{
+			memcpy(&header, texture.file.Data(), sizeof(Header));
+			valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION &&
+				header.sourceHash == sourceHash && header.width == (uint32_t)size && header.height == (uint32_t)size &&
+				(header.channels == 3 || header.channels == 4);
+		}
+
+		if (valid)
+		{
+			texture.format = header.channels == 3 ? GL_RGB : GL_RGBA;
+			texture.width = (GLsizei)header.width;
+			texture.height = (GLsizei)header.height;
+			size_t end = LayOutLevels(texture, header.channels, sizeof(Header));
+			valid = header.levelCount == texture.levels.size() && end == texture.file.Size();
+		}
+
+		if (!valid)
+			texture = CachedTexture();
+		return valid;
+	}
+
+	// Write the file next to its final name first, so a cut-short write never leaves a bad entry
+	bool WriteEntry(const std::string& cachePath, const Header& header, const std::vector<unsigned char>& pixels)
+	{
+		std::string partPath = cachePath + ".part";
+		FILE* file = fopen(partPath.c_str(), "wb");
+		if (!file)
+			return false;
+
+		bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+		written = fclose(file) == 0 && written;
+
+		remove(cachePath.c_str());
+		if (!written || rename(partPath.c_str(), cachePath.c_str()) != 0)
+		{
+			remove(partPath.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	///////////////////////////////////////////////////
+	//	BuildEntry(const std::string&, const std::vector<unsigned char>&, uint64_t, GLsizei, bool, CachedTexture&)
+	//
+	//	Decode the image file's bytes, scale it to
+	//	size x size, turn the rows bottom-up, build the
+	//	mip chain and, when asked, write it all to the
+	//	cache; the texture keeps the chain
+	///////////////////////////////////////////////////
+	bool BuildEntry(const std::string& cachePath, const std::vector<unsigned char>& source, uint64_t sourceHash, GLsizei size,
+		bool writeEntry, CachedTexture& texture)
+	{
+		PROFILE_ZONE("BuildTextureCache");
+
+		int width, height, channels;
+		unsigned char* image = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &channels, 0);
+		if (!image)
+			return false;
+
+		if (channels != 3 && channels != 4)
+		{
+			std::cout << "Not implemented to handle image with " << channels << " channels" << std::endl;
+			stbi_image_free(image);
+			return false;
+		}
+
+		// Every layer of an array texture has the same size
+		std::vector<unsigned char> scaled;
+		const unsigned char* top = image;
+		if (width != size || height != size)
+		{
+			scaled.resize((size_t)size * size * channels);
+			resampleImage(image, width, height, channels, scaled.data(), size, size);
+			top = scaled.data();
+			width = size;
+			height = size;
+		}
+
+		texture.format = channels == 3 ? GL_RGB : GL_RGBA;
+		texture.width = width;
+		texture.height = height;
+		texture.pixels.resize(LayOutLevels(texture, channels, 0));
+
+		// Level 0 is the image with its rows in GL's bottom-up order
+		size_t rowBytes = (size_t)width * channels;
+		for (int row = 0; row < height; ++row)
+			memcpy(&texture.pixels[row * rowBytes], top + (height - 1 - row) * rowBytes, rowBytes);
+		stbi_image_free(image);
+
+		for (size_t level = 1; level < texture.levels.size(); ++level)
+		{
+			downsampleImage(&texture.pixels[texture.levels[level - 1].offset], std::max(1, width >> (level - 1)),
+				std::max(1, height >> (level - 1)), channels, &texture.pixels[texture.levels[level].offset]);
+		}
+
+		Header header;
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.sourceHash = sourceHash;
+		header.width = (uint32_t)width;
+		header.height = (uint32_t)height;
+		header.channels = (uint32_t)channels;
+		header.levelCount = (uint32_t)texture.levels.size();
+
+		// The texture is good either way; only the next launch pays for a failed write
+		if (writeEntry && !WriteEntry(cachePath, header, texture.pixels))
+			std::cout << "WARNING: cannot write texture cache " << cachePath << std::endl;
+		return true;
+	}
+}
+
+namespace TextureCache
+{
+	std::string CachePath(const char* imagePath)
+	{
+		return std::string(imagePath) + ".texcache";
+	}
+
+	///////////////////////////////////////////////////
+	//	Load(const char*, GLsizei, CachedTexture&, bool)
+	//
+	//	imagePath: source image file
+	//	size: width and height of level 0
+	//	texture: receives the chain, mapped from the
+	//	cache on a hit, built in memory on a miss
+	//	useCache: false to build in memory every time
+	//
+	//	The image file is read and hashed either way;
+	//	it is only decoded on a miss
+	///////////////////////////////////////////////////
+	bool Load(const char* imagePath, GLsizei size, CachedTexture& texture, bool useCache)
+	{
+		PROFILE_ZONE("TextureCache::Load");
+
+		texture = CachedTexture();
+
+		std::vector<unsigned char> source;
+		if (!ReadFile(imagePath, source))
+			return false;
+
+		uint64_t sourceHash = HashBytes(source.data(), source.size());
+		std::string cachePath = CachePath(imagePath);
+		if (useCache && MapEntry(cachePath, sourceHash, size, texture))
+			return true;
+
+		return BuildEntry(cachePath, source, sourceHash, size, useCache, texture);
+	}
+}
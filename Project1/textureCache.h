@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureCache.h
+// ========
+// on-disk cache of decoded textures with their full mip chain
+//
+// The first load of an image decodes it, scales it to the square size the
+// texture arrays share, turns its rows bottom-up, builds every mip level
+// with a box filter and writes all of it to a .texcache
+// file next to the image, tagged with a hash of the image file's bytes.
+// Later loads hash the image again and, when the tag still matches, map
+// the cache file and hand its levels out in place: no stbi_load, no flip
+// and no mipmap generation, and the pixels reach the staging ring without
+// passing through a heap buffer. Editing the image changes its hash, so
+// the next load rebuilds the entry, and so does asking for another size.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "compressedTexture.h"
+#include "mappedFile.h"
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+// A decoded texture with every mip level, rows bottom-up and tightly packed
+struct CachedTexture
+{
+	GLenum format = 0;                  // GL_RGB or GL_RGBA, 0 when empty
+	GLsizei width = 0;
+	GLsizei height = 0;
+	std::vector<TextureLevel> levels;   // Level 0 first, as ranges of Data()
+	MappedFile file;                    // The cache file, on a hit
+	std::vector<unsigned char> pixels;  // The levels just built, on a miss
+
+	const unsigned char* Data() const { return file.IsOpen() ? file.Data() : pixels.data(); }
+};
+
+namespace TextureCache
+{
+	// The cache file of a source image: its path with .texcache appended
+	std::string CachePath(const char* imagePath);
+
+	// Load an image scaled to size x size through its cache entry, building
+	// and writing the entry when it is missing or stale; safe to run on any
+	// thread. Without useCache the chain is built in memory and nothing is
+	// written. False only when the image itself cannot be loaded; failing to
+	// write the entry is reported.
+	bool Load(const char* imagePath, GLsizei size, CachedTexture& texture, bool useCache);
+}
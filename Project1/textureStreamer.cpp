@@ -0,0 +1,272 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureStreamer.cpp
+// ========
+// asynchronous texture uploads through a fenced pixel-unpack staging ring
+///////////////////////////////////////////////////////////////////////////////
+
+#include "textureStreamer.h"
+#include "glResources.h"
+#include "glTrace.h"
+#include "cpuProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	// Offsets handed to glTexSubImage3D stay 4-byte aligned
+	const GLsizeiptr STAGING_ALIGNMENT = 4;
+}
+
+///////////////////////////////////////////////////
+//	Create(GLsizeiptr, GLsizeiptr)
+//
+//	stagingBytes: size of the staging ring
+//	bytesPerFrame: upload budget of one Update()
+//
+//	Create the staging buffer and keep it mapped
+///////////////////////////////////////////////////
+bool TextureStreamer::Create(GLsizeiptr stagingBytes, GLsizeiptr bytesPerFrame)
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	mSize = stagingBytes;
+	mBytesPerFrame = bytesPerFrame;
+	mBuffer = CreateImmutableBuffer(mSize, NULL, flags);
+	mMapped = (unsigned char*)MapBufferRange(mBuffer, 0, mSize, flags);
+
+	if (mMapped == nullptr)
+	{
+		std::cout << "ERROR::TEXTURE_STREAMER::MAP_FAILED" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	mHead = 0;
+	mUsed = 0;
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	Destroy()
+//
+//	Drop every upload still in progress; slots keep
+//	whatever layer they point at
+///////////////////////////////////////////////////
+void TextureStreamer::Destroy()
+{
+	for (Band& band : mBands)
+		glDeleteSync(band.fence);
+	mBands.clear();
+	mSwapsInFlight = 0;
+	mJobs.clear();
+
+	if (mMapped != nullptr)
+		UnmapBuffer(mBuffer);
+	DeleteBuffer(mBuffer);
+
+	mMapped = nullptr;
+	mSize = 0;
+}
+
+///////////////////////////////////////////////////
+//	Queue(TextureSlot*, GLuint, GLint, CompressedTexture&&)
+//
+//	The cooked levels are uploaded as they are,
+//	over the next frames
+///////////////////////////////////////////////////
+void TextureStreamer::Queue(TextureSlot* slot, GLuint array, GLint layer, CompressedTexture&& texture)
+{
+	Job job;
+	job.slot = slot;
+	job.target = { array, layer };
+	job.width = texture.width;
+	job.height = texture.height;
+	job.format = texture.internalFormat;
+	job.nextLevel = 0;
+	job.nextRow = 0;
+	job.compressed = std::move(texture);
+
+	mJobs.push_back(std::move(job));
+}
+
+void TextureStreamer::Queue(TextureSlot* slot, GLuint array, GLint layer, CachedTexture&& texture)
+{
+	Job job;
+	job.slot = slot;
+	job.target = { array, layer };
+	job.width = texture.width;
+	job.height = texture.height;
+	job.format = texture.format;
+	job.nextLevel = 0;
+	job.nextRow = 0;
+	job.cached = std::move(texture);
+
+	mJobs.push_back(std::move(job));
+}
+
+///////////////////////////////////////////////////
+//	Update()
+//
+//	Release the staging space of every band the GPU
+//	has consumed, point slots at finished layers,
+//	then upload bands until the frame budget or the
+//	staging ring runs out
+///////////////////////////////////////////////////
+void TextureStreamer::Update()
+{
+	PROFILE_ZONE("TextureStreamer");
+
+	// Bands complete in submission order, so stop at the first busy one
+	while (!mBands.empty())
+	{
+		Band& band = mBands.front();
+		GLenum status = glClientWaitSync(band.fence, 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED)
+			break;
+
+		glDeleteSync(band.fence);
+		mUsed -= band.consumed;
+		if (band.slot)
+		{
+			*band.slot = band.target;
+			--mSwapsInFlight;
+		}
+		mBands.pop_front();
+	}
+
+	if (mUsed == 0)
+		mHead = 0;
+
+	GLsizeiptr budget = mBytesPerFrame;
+	while (!mJobs.empty() && budget > 0)
+	{
+		Job& job = mJobs.front();
+		if (!UploadLevelBand(job, budget))
+			break;
+
+		size_t levelCount = job.compressed.levels.size() + job.cached.levels.size();
+		if (job.nextLevel == (GLsizei)levelCount)
+			mJobs.pop_front();
+	}
+}
+
+///////////////////////////////////////////////////
+//	UploadLevelBand(Job&, GLsizeiptr&)
+//
+//	Stage and upload the next band of rows of the
+//	job's current level into its layer, out of
+//	budget. False when it has to wait for a later
+//	frame.
+///////////////////////////////////////////////////
+bool TextureStreamer::UploadLevelBand(Job& job, GLsizeiptr& budget)
+{
+	bool compressed = !job.compressed.levels.empty();
+	const std::vector<TextureLevel>& levels = compressed ? job.compressed.levels : job.cached.levels;
+	const TextureLevel& level = levels[job.nextLevel];
+	const unsigned char* data = (compressed ? job.compressed.data.data() : job.cached.Data()) + level.offset;
+
+	// A compressed level goes up in rows of 4x4 blocks
+	GLsizei width = std::max(1, job.width >> job.nextLevel);
+	GLsizei height = std::max(1, job.height >> job.nextLevel);
+	GLsizei rowHeight = compressed ? 4 : 1;
+	GLsizei rowCount = (height + rowHeight - 1) / rowHeight;
+	GLsizeiptr rowBytes = (GLsizeiptr)level.size / rowCount;
+
+	// A band never takes more than half the ring, so one can always follow another.
+	// A row larger than the whole budget still goes, alone, on a frame of its own.
+	GLsizeiptr rowLimit = std::min(budget, mSize / 2) / rowBytes;
+	if (rowLimit == 0 && budget == mBytesPerFrame && rowBytes <= mSize / 2)
+		rowLimit = 1;
+
+	GLsizei rows = (GLsizei)std::min<GLsizeiptr>(rowCount - job.nextRow, rowLimit);
+	const void* source = data + job.nextRow * rowBytes;
+	GLsizeiptr consumed = 0;
+	if (rows == 0)
+	{
+		// Rows larger than half the ring go straight from memory, the rest of the level at once
+		if (rowBytes <= mSize / 2)
+			return false;
+		rows = rowCount - job.nextRow;
+	}
+	else
+	{
+		GLintptr offset;
+		if (!Reserve(rows * rowBytes, offset, consumed))
+			return false;
+
+		memcpy(mMapped + offset, source, rows * rowBytes);
+		source = (const void*)offset;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+	}
+
+	GLint y = job.nextRow * rowHeight;
+	GLsizei bandHeight = std::min(rows * rowHeight, height - y);
+	if (compressed)
+	{
+		UploadCompressedTextureLayerRegion(job.target.array, job.nextLevel, 0, y, job.target.layer, width, bandHeight,
+			job.format, (GLsizei)(rows * rowBytes), source);
+	}
+	else
+	{
+		// Rows of RGB data are tightly packed, not 4-byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		UploadTextureLayerRegion(job.target.array, job.nextLevel, 0, y, job.target.layer, width, bandHeight,
+			job.format, GL_UNSIGNED_BYTE, source);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	budget -= rows * rowBytes;
+	job.nextRow += rows;
+	if (job.nextRow == rowCount)
+	{
+		job.nextRow = 0;
+		++job.nextLevel;
+	}
+
+	// The whole chain is in once the last band's fence signals
+	Band band = { NULL, consumed, NULL, { 0, 0 } };
+	if (job.nextLevel == (GLsizei)levels.size())
+	{
+		band.slot = job.slot;
+		band.target = job.target;
+		++mSwapsInFlight;
+	}
+	band.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	mBands.push_back(band);
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	Reserve(GLsizeiptr, GLintptr&, GLsizeiptr&)
+//
+//	bytes: contiguous staging bytes wanted
+//	offset: receives their offset in the ring
+//	consumed: receives the bytes to release later,
+//	including any end of the ring skipped to wrap
+//
+//	False when the space is still in use
+///////////////////////////////////////////////////
+bool TextureStreamer::Reserve(GLsizeiptr bytes, GLintptr& offset, GLsizeiptr& consumed)
+{
+	bytes = (bytes + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+
+	GLintptr start = mHead;
+	GLsizeiptr skipped = 0;
+	if (start + bytes > mSize)
+	{
+		skipped = mSize - start;
+		start = 0;
+	}
+
+	if (skipped + bytes > mSize - mUsed)
+		return false;
+
+	offset = start;
+	consumed = skipped + bytes;
+	mHead = (start + bytes) % mSize;
+	mUsed += consumed;
+	return true;
+}
@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureStreamer.h
+// ========
+// asynchronous texture uploads through a fenced pixel-unpack staging ring
+//
+// Textures are layers of 2D array textures. A slot names the array and
+// layer a material samples; it first points at a placeholder, so the scene
+// can be drawn before any image is in. Every level of a queued texture is
+// copied a band of rows at a time (rows of 4x4 blocks when compressed)
+// into a persistently mapped GL_PIXEL_UNPACK_BUFFER and uploaded from
+// there into its layer. Bands go up within a per-frame byte budget, so a
+// large image never stalls a single frame. Every band is followed by a
+// fence; staging space is reused once its fence signals. The slot is
+// pointed at the new layer as soon as the fence after its last band
+// signals. Update() never waits on a fence, so the render loop is never
+// blocked by an upload.
+//
+// Textures arrive with their whole mip chain, cooked files from
+// LoadKtx2() or decoded chains from the TextureCache, so nothing is
+// generated on the GPU. The arrays belong to the caller.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "compressedTexture.h"
+#include "textureCache.h"
+
+#include <GL/glew.h>
+
+#include <deque>
+
+// Where a material's texture lives: an array texture and one of its layers
+struct TextureSlot
+{
+	GLuint array;
+	GLint layer;
+};
+
+class TextureStreamer
+{
+public:
+	// stagingBytes: size of the staging ring
+	// bytesPerFrame: pixel bytes copied and uploaded by one Update()
+	bool Create(GLsizeiptr stagingBytes, GLsizeiptr bytesPerFrame);
+	void Destroy();
+
+	// Stream every level of a cooked texture into one layer of array, then
+	// point *slot at it. The array's format and size are the texture's, and
+	// the format must pass HasCompressedFormat().
+	void Queue(TextureSlot* slot, GLuint array, GLint layer, CompressedTexture&& texture);
+
+	// Stream every level of a decoded chain, rows bottom-up, into one layer
+	// of array, then point *slot at it
+	void Queue(TextureSlot* slot, GLuint array, GLint layer, CachedTexture&& texture);
+
+	// Once per frame: point slots at finished layers and upload the next bands
+	void Update();
+
+	// Textures queued but not yet in their slots
+	size_t PendingCount() const { return mJobs.size() + mSwapsInFlight; }
+
+private:
+	struct Job
+	{
+		TextureSlot* slot;
+		TextureSlot target;             // Layer being filled
+		GLsizei width;
+		GLsizei height;
+		GLenum format;                  // Compressed internal format, or GL_RGB / GL_RGBA
+		CompressedTexture compressed;   // Cooked levels
+		CachedTexture cached;           // Decoded levels, when not cooked
+		GLsizei nextLevel;              // First level not uploaded yet
+		GLsizei nextRow;                // First row of it not uploaded yet
+	};
+
+	// Staging space in use until the GPU has read it
+	struct Band
+	{
+		GLsync fence;
+		GLsizeiptr consumed;        // Ring bytes to release, wrap padding included
+		TextureSlot* slot;          // Set on a texture's last band
+		TextureSlot target;
+	};
+
+	bool Reserve(GLsizeiptr bytes, GLintptr& offset, GLsizeiptr& consumed);
+	bool UploadLevelBand(Job& job, GLsizeiptr& budget);
+
+	GLuint mBuffer = 0;
+	unsigned char* mMapped = nullptr;
+	GLsizeiptr mSize = 0;
+	GLsizeiptr mBytesPerFrame = 0;
+
+	// Circular staging allocation: bytes are handed out at mHead and
+	// released in the same order their bands' fences signal
+	GLintptr mHead = 0;
+	GLsizeiptr mUsed = 0;
+
+	std::deque<Job> mJobs;          // Waiting or partly uploaded, in queue order
+	std::deque<Band> mBands;        // Submitted, oldest first
+	size_t mSwapsInFlight = 0;      // Last bands not signaled yet
+};
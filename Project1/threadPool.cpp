@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// threadPool.cpp
+// ========
+// fixed set of worker threads running queued jobs in submission order
+///////////////////////////////////////////////////////////////////////////////
+
+#include "threadPool.h"
+#include "cpuProfiler.h"
+
+///////////////////////////////////////////////////
+//	Create(unsigned int, const char*)
+//
+//	threadCount: workers to start, 0 for one per
+//	hardware thread left over by the main thread
+//	threadName: label of the workers in traces
+///////////////////////////////////////////////////
+void ThreadPool::Create(unsigned int threadCount, const char* threadName)
+{
+	Destroy();
+
+	// hardware_concurrency() may report 0 when the core count is unknown
+	if (threadCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		threadCount = cores > 1 ? cores - 1 : 1;
+	}
+
+	mThreadName = threadName;
+	mStopping = false;
+	for (unsigned int i = 0; i < threadCount; ++i)
+		mThreads.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+void ThreadPool::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mWake.notify_all();
+
+	for (std::thread& thread : mThreads)
+		thread.join();
+
+	mThreads.clear();
+}
+
+void ThreadPool::Submit(Job job)
+{
+	if (mThreads.empty())
+	{
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJobs.push_back(std::move(job));
+	}
+	mWake.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	PROFILE_THREAD(mThreadName);
+
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+
+			// Stopping still drains the queue so no submitted job is lost
+			if (mJobs.empty())
+				return;
+
+			job = std::move(mJobs.front());
+			mJobs.pop_front();
+		}
+
+		job();
+	}
+}
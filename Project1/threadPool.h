@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////////////
+// threadPool.h
+// ========
+// fixed set of worker threads running queued jobs in submission order
+//
+// Jobs must not touch GL: the context is only current on the main thread.
+// A pool that was never created runs every job inline in Submit(), so
+// callers work the same way with or without workers.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	typedef std::function<void()> Job;
+
+public:
+	~ThreadPool() { Destroy(); }
+
+	// Start threadCount workers; 0 uses every hardware thread but the main one's.
+	// threadName labels the workers in CPU traces and must outlive the pool.
+	void Create(unsigned int threadCount = 0, const char* threadName = "Worker");
+
+	// Run the jobs still queued, then join the workers
+	void Destroy();
+
+	// Queue a job; it runs inline when the pool has no workers
+	void Submit(Job job);
+
+	unsigned int ThreadCount() const { return (unsigned int)mThreads.size(); }
+
+private:
+	void WorkerLoop();
+
+	std::vector<std::thread> mThreads;
+	std::deque<Job> mJobs;
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	bool mStopping = false;
+	const char* mThreadName = "Worker";
+};
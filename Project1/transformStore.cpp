@@ -0,0 +1,386 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformStore.cpp
+// ========
+// scene transforms kept as structure-of-arrays, with the world, normal and
+// MVP matrices precomputed on the CPU and uploaded as one packed buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "transformStore.h"
+#include "glResources.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define TRANSFORM_STORE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	// Transforms composed together by one SIMD pass
+	const size_t GROUP_SIZE = 4;
+
+	// Initial size of the storage buffer, grown by doubling
+	const GLsizeiptr INITIAL_CAPACITY = 256 * sizeof(GPUTransform);
+
+	// out = a * b, all column-major 4x4
+	void MultiplyMatrix(const float* a, const float* b, float* out)
+	{
+#ifdef TRANSFORM_STORE_SSE
+		__m128 a0 = _mm_loadu_ps(a + 0);
+		__m128 a1 = _mm_loadu_ps(a + 4);
+		__m128 a2 = _mm_loadu_ps(a + 8);
+		__m128 a3 = _mm_loadu_ps(a + 12);
+
+		for (int column = 0; column < 4; ++column)
+		{
+			const float* bColumn = b + column * 4;
+			__m128 result = _mm_mul_ps(a0, _mm_set1_ps(bColumn[0]));
+			result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(bColumn[1])));
+			result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(bColumn[2])));
+			result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(bColumn[3])));
+			_mm_storeu_ps(out + column * 4, result);
+		}
+#else
+		for (int column = 0; column < 4; ++column)
+			for (int row = 0; row < 4; ++row)
+				out[column * 4 + row] =
+					a[0 * 4 + row] * b[column * 4 + 0] +
+					a[1 * 4 + row] * b[column * 4 + 1] +
+					a[2 * 4 + row] * b[column * 4 + 2] +
+					a[3 * 4 + row] * b[column * 4 + 3];
+#endif
+	}
+}
+
+///////////////////////////////////////////////////
+//	Create(GLuint)
+//
+//	bindingPoint: shader storage block binding point
+//
+//	Allocate the storage buffer the surface shader
+//	reads the transforms from
+///////////////////////////////////////////////////
+void TransformStore::Create(GLuint bindingPoint)
+{
+	mBinding = bindingPoint;
+	mCapacity = std::max(INITIAL_CAPACITY, (GLsizeiptr)(mCount * sizeof(GPUTransform)));
+
+	// Only ever written by GPU copies from the ring, so no storage flags are needed
+	mBuffer = CreateImmutableBuffer(mCapacity, NULL, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, mBinding, mBuffer);
+
+	// Anything added before the buffer existed still has to be sent
+	mUploadBegin = 0;
+	mUploadEnd = mCount;
+}
+
+void TransformStore::Destroy()
+{
+	DeleteBuffer(mBuffer);
+	mCapacity = 0;
+}
+
+void TransformStore::Clear()
+{
+	mCount = 0;
+	mPositionX.clear(); mPositionY.clear(); mPositionZ.clear();
+	mRotationX.clear(); mRotationY.clear(); mRotationZ.clear(); mRotationW.clear();
+	mScaleX.clear(); mScaleY.clear(); mScaleZ.clear();
+	mDirtyGroups.clear();
+	mTransforms.clear();
+
+	// Force every MVP of the next scene to be built
+	mViewProjection = glm::mat4(0.0f);
+	mUploadBegin = SIZE_MAX;
+	mUploadEnd = 0;
+}
+
+///////////////////////////////////////////////////
+//	Add(...)
+//
+//	Append a transform and return its index in the
+//	storage buffer
+///////////////////////////////////////////////////
+TransformStore::Handle TransformStore::Add(const glm::vec3& position, float rotationAngle, const glm::vec3& rotationAxis, const glm::vec3& scale)
+{
+	// Open a new group, padded with identity transforms
+	if (mCount % GROUP_SIZE == 0)
+	{
+		size_t padded = mCount + GROUP_SIZE;
+		mPositionX.resize(padded, 0.0f);
+		mPositionY.resize(padded, 0.0f);
+		mPositionZ.resize(padded, 0.0f);
+		mRotationX.resize(padded, 0.0f);
+		mRotationY.resize(padded, 0.0f);
+		mRotationZ.resize(padded, 0.0f);
+		mRotationW.resize(padded, 1.0f);
+		mScaleX.resize(padded, 1.0f);
+		mScaleY.resize(padded, 1.0f);
+		mScaleZ.resize(padded, 1.0f);
+		mDirtyGroups.push_back(0);
+	}
+
+	Handle handle = (Handle)mCount++;
+	mTransforms.push_back(GPUTransform());
+
+	SetPosition(handle, position);
+	SetRotation(handle, rotationAngle, rotationAxis);
+	SetScale(handle, scale);
+
+	return handle;
+}
+
+void TransformStore::SetPosition(Handle handle, const glm::vec3& position)
+{
+	mPositionX[handle] = position.x;
+	mPositionY[handle] = position.y;
+	mPositionZ[handle] = position.z;
+	MarkDirty(handle);
+}
+
+void TransformStore::SetRotation(Handle handle, float rotationAngle, const glm::vec3& rotationAxis)
+{
+	// Unit quaternion for the same rotation glm::rotate(angle, axis) builds
+	glm::vec3 axis = glm::normalize(rotationAxis);
+	float s = std::sin(rotationAngle * 0.5f);
+
+	mRotationX[handle] = axis.x * s;
+	mRotationY[handle] = axis.y * s;
+	mRotationZ[handle] = axis.z * s;
+	mRotationW[handle] = std::cos(rotationAngle * 0.5f);
+	MarkDirty(handle);
+}
+
+///////////////////////////////////////////////////
+//	Rotate(Handle, float, const glm::vec3&)
+//
+//	Pre-multiply the stored rotation, so the new
+//	rotation is applied after the existing one
+///////////////////////////////////////////////////
+void TransformStore::Rotate(Handle handle, float rotationAngle, const glm::vec3& rotationAxis)
+{
+	glm::vec3 axis = glm::normalize(rotationAxis);
+	float s = std::sin(rotationAngle * 0.5f);
+	float ax = axis.x * s, ay = axis.y * s, az = axis.z * s, aw = std::cos(rotationAngle * 0.5f);
+
+	float bx = mRotationX[handle], by = mRotationY[handle], bz = mRotationZ[handle], bw = mRotationW[handle];
+
+	// Hamilton product a * b
+	mRotationX[handle] = aw * bx + ax * bw + ay * bz - az * by;
+	mRotationY[handle] = aw * by - ax * bz + ay * bw + az * bx;
+	mRotationZ[handle] = aw * bz + ax * by - ay * bx + az * bw;
+	mRotationW[handle] = aw * bw - ax * bx - ay * by - az * bz;
+	MarkDirty(handle);
+}
+
+void TransformStore::SetScale(Handle handle, const glm::vec3& scale)
+{
+	mScaleX[handle] = scale.x;
+	mScaleY[handle] = scale.y;
+	mScaleZ[handle] = scale.z;
+	MarkDirty(handle);
+}
+
+glm::vec3 TransformStore::Position(Handle handle) const
+{
+	return glm::vec3(mPositionX[handle], mPositionY[handle], mPositionZ[handle]);
+}
+
+///////////////////////////////////////////////////
+//	Update(const glm::mat4&)
+//
+//	viewProjection: projection * view of this frame
+//
+//	Recompose dirty groups and refresh the MVPs
+///////////////////////////////////////////////////
+void TransformStore::Update(const glm::mat4& viewProjection)
+{
+	bool viewChanged = viewProjection != mViewProjection;
+	mViewProjection = viewProjection;
+
+	for (size_t group = 0; group < mDirtyGroups.size(); ++group)
+	{
+		size_t first = group * GROUP_SIZE;
+		size_t last = std::min(first + GROUP_SIZE, mCount);
+
+		if (mDirtyGroups[group])
+		{
+			ComposeGroup(group);
+			mDirtyGroups[group] = 0;
+
+			mUploadBegin = std::min(mUploadBegin, first);
+			mUploadEnd = std::max(mUploadEnd, last);
+		}
+		else if (!viewChanged)
+			continue;
+
+		for (size_t i = first; i < last; ++i)
+			ComposeMvp(i);
+	}
+
+	if (viewChanged)
+	{
+		mUploadBegin = 0;
+		mUploadEnd = mCount;
+	}
+}
+
+///////////////////////////////////////////////////
+//	Upload(RingBuffer&)
+//
+//	ring: dynamic buffer of the current frame
+//
+//	Write the changed range of entries into mapped
+//	ring memory and have the GPU copy it into the
+//	storage buffer, in order with the frame's draws
+///////////////////////////////////////////////////
+void TransformStore::Upload(RingBuffer& ring)
+{
+	if (mBuffer == 0 || mUploadBegin >= mUploadEnd)
+		return;
+
+	GLsizeiptr bytes = (GLsizeiptr)(mCount * sizeof(GPUTransform));
+
+	// The store is too small: replace it with a larger one and send everything.
+	// Draws still in flight keep the old store alive until they complete.
+	if (bytes > mCapacity)
+	{
+		while (mCapacity < bytes)
+			mCapacity *= 2;
+
+		DeleteBuffer(mBuffer);
+		mBuffer = CreateImmutableBuffer(mCapacity, NULL, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, mBinding, mBuffer);
+
+		mUploadBegin = 0;
+		mUploadEnd = mCount;
+	}
+
+	GLsizeiptr rangeBytes = (GLsizeiptr)((mUploadEnd - mUploadBegin) * sizeof(GPUTransform));
+
+	// Out of ring space: keep the range pending, the ring grows next frame
+	RingBuffer::Allocation staging = ring.Allocate(rangeBytes, sizeof(glm::vec4));
+	if (!staging.IsValid())
+		return;
+
+	memcpy(staging.data, &mTransforms[mUploadBegin], rangeBytes);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, ring.id);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, staging.offset,
+		(GLintptr)(mUploadBegin * sizeof(GPUTransform)), rangeBytes);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	mUploadBegin = SIZE_MAX;
+	mUploadEnd = 0;
+}
+
+void TransformStore::MarkDirty(Handle handle)
+{
+	mDirtyGroups[handle / GROUP_SIZE] = 1;
+}
+
+///////////////////////////////////////////////////
+//	ComposeGroup(size_t)
+//
+//	group: index of a group of 4 transforms
+//
+//	Build world = T * R * S and normal = R * S^-1
+//	for four transforms at once. For a rotation and
+//	scale the inverse-transpose reduces to dividing
+//	each rotation column by its scale.
+///////////////////////////////////////////////////
+void TransformStore::ComposeGroup(size_t group)
+{
+	const size_t base = group * GROUP_SIZE;
+
+	// [element][lane]: 3x3 column-major rotation-scale and normal matrices
+	float world[9][GROUP_SIZE];
+	float normal[9][GROUP_SIZE];
+
+#ifdef TRANSFORM_STORE_SSE
+	__m128 x = _mm_loadu_ps(&mRotationX[base]);
+	__m128 y = _mm_loadu_ps(&mRotationY[base]);
+	__m128 z = _mm_loadu_ps(&mRotationZ[base]);
+	__m128 w = _mm_loadu_ps(&mRotationW[base]);
+
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+
+	__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+	__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+	__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+	__m128 rotation[9] = {
+		_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))),
+		_mm_mul_ps(two, _mm_add_ps(xy, wz)),
+		_mm_mul_ps(two, _mm_sub_ps(xz, wy)),
+		_mm_mul_ps(two, _mm_sub_ps(xy, wz)),
+		_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))),
+		_mm_mul_ps(two, _mm_add_ps(yz, wx)),
+		_mm_mul_ps(two, _mm_add_ps(xz, wy)),
+		_mm_mul_ps(two, _mm_sub_ps(yz, wx)),
+		_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)))
+	};
+
+	__m128 scale[3] = {
+		_mm_loadu_ps(&mScaleX[base]),
+		_mm_loadu_ps(&mScaleY[base]),
+		_mm_loadu_ps(&mScaleZ[base])
+	};
+
+	for (int column = 0; column < 3; ++column)
+	{
+		__m128 inverseScale = _mm_div_ps(one, scale[column]);
+		for (int row = 0; row < 3; ++row)
+		{
+			_mm_storeu_ps(world[column * 3 + row], _mm_mul_ps(rotation[column * 3 + row], scale[column]));
+			_mm_storeu_ps(normal[column * 3 + row], _mm_mul_ps(rotation[column * 3 + row], inverseScale));
+		}
+	}
+#else
+	for (size_t lane = 0; lane < GROUP_SIZE; ++lane)
+	{
+		float x = mRotationX[base + lane], y = mRotationY[base + lane];
+		float z = mRotationZ[base + lane], w = mRotationW[base + lane];
+
+		float rotation[9] = {
+			1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y),
+			2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x),
+			2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y)
+		};
+		float scale[3] = { mScaleX[base + lane], mScaleY[base + lane], mScaleZ[base + lane] };
+
+		for (int column = 0; column < 3; ++column)
+			for (int row = 0; row < 3; ++row)
+			{
+				world[column * 3 + row][lane] = rotation[column * 3 + row] * scale[column];
+				normal[column * 3 + row][lane] = rotation[column * 3 + row] / scale[column];
+			}
+	}
+#endif
+
+	// Scatter the lanes into the packed output entries
+	for (size_t lane = 0; lane < GROUP_SIZE && base + lane < mCount; ++lane)
+	{
+		GPUTransform& transform = mTransforms[base + lane];
+
+		for (int column = 0; column < 3; ++column)
+		{
+			transform.world[column] = glm::vec4(world[column * 3 + 0][lane], world[column * 3 + 1][lane], world[column * 3 + 2][lane], 0.0f);
+			transform.normalMatrix[column] = glm::vec4(normal[column * 3 + 0][lane], normal[column * 3 + 1][lane], normal[column * 3 + 2][lane], 0.0f);
+		}
+		transform.world[3] = glm::vec4(mPositionX[base + lane], mPositionY[base + lane], mPositionZ[base + lane], 1.0f);
+	}
+}
+
+void TransformStore::ComposeMvp(size_t index)
+{
+	GPUTransform& transform = mTransforms[index];
+	MultiplyMatrix(&mViewProjection[0][0], &transform.world[0][0], &transform.mvp[0][0]);
+}
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformStore.h
+// ========
+// scene transforms kept as structure-of-arrays, with the world, normal and
+// MVP matrices precomputed on the CPU and uploaded as one packed buffer
+//
+// Positions, rotations (unit quaternions) and scales are stored one float
+// component per array, padded to a multiple of four entries, so Update()
+// can compose four transforms per SSE instruction. Only groups marked
+// dirty are recomposed; MVPs are rebuilt for dirty groups, or for every
+// transform when the view-projection matrix changes. The results land in
+// GPUTransform entries (sceneData.h) that the surface shader reads by
+// index, so it never inverts a matrix per vertex. Changed entries are
+// staged in the frame's RingBuffer section and copied into the storage
+// buffer on the GPU.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "ringBuffer.h"
+#include "sceneData.h"
+
+class TransformStore
+{
+public:
+	typedef uint32_t Handle;
+
+public:
+	void Create(GLuint bindingPoint);
+	void Destroy();
+
+	// Drop every transform; the storage buffer is kept for reuse
+	void Clear();
+
+	// Add a transform composed as translate * rotate(angle, axis) * scale
+	Handle Add(const glm::vec3& position, float rotationAngle, const glm::vec3& rotationAxis, const glm::vec3& scale);
+
+	void SetPosition(Handle handle, const glm::vec3& position);
+	void SetRotation(Handle handle, float rotationAngle, const glm::vec3& rotationAxis);
+	void SetScale(Handle handle, const glm::vec3& scale);
+
+	// Apply a further rotation on top of the current one, in world space
+	void Rotate(Handle handle, float rotationAngle, const glm::vec3& rotationAxis);
+
+	glm::vec3 Position(Handle handle) const;
+
+	// Recompute the matrices of dirty transforms, and every MVP if the
+	// view-projection matrix differs from the previous call
+	void Update(const glm::mat4& viewProjection);
+
+	// Stage the entries changed by Update() in the ring and copy them into
+	// the storage buffer
+	void Upload(RingBuffer& ring);
+
+	size_t Size() const { return mCount; }
+	const GPUTransform& Matrices(Handle handle) const { return mTransforms[handle]; }
+
+private:
+	void MarkDirty(Handle handle);
+	void ComposeGroup(size_t group);
+	void ComposeMvp(size_t index);
+
+	size_t mCount = 0;
+
+	// Inputs, one array per component, padded to a multiple of 4
+	std::vector<float> mPositionX, mPositionY, mPositionZ;
+	std::vector<float> mRotationX, mRotationY, mRotationZ, mRotationW;
+	std::vector<float> mScaleX, mScaleY, mScaleZ;
+
+	// One flag per group of 4 transforms
+	std::vector<uint8_t> mDirtyGroups;
+
+	// Outputs, in the layout of the storage buffer
+	std::vector<GPUTransform> mTransforms;
+	glm::mat4 mViewProjection = glm::mat4(0.0f);
+
+	// Range of mTransforms changed since the last Upload()
+	size_t mUploadBegin = SIZE_MAX;
+	size_t mUploadEnd = 0;
+
+	GLuint mBuffer = 0;
+	GLuint mBinding = 0;
+	GLsizeiptr mCapacity = 0;
+};
@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformBuffer.cpp
+// ========
+// buffer object bound to a fixed uniform block binding point
+///////////////////////////////////////////////////////////////////////////////
+
+#include "uniformBuffer.h"
+#include "glResources.h"
+
+///////////////////////////////////////////////////
+//	Create(GLuint, GLsizeiptr, const void*)
+//
+//	bindingPoint: uniform block binding the buffer is attached to
+//	byteSize: size of the buffer store
+//	data: optional initial contents
+//
+//	Allocate the immutable buffer store and attach
+//	it to its binding point
+///////////////////////////////////////////////////
+void UniformBuffer::Create(GLuint bindingPoint, GLsizeiptr byteSize, const void* data)
+{
+	binding = bindingPoint;
+	size = byteSize;
+
+	// Dynamic storage keeps Update() possible on the immutable store
+	id = CreateImmutableBuffer(size, data, GL_DYNAMIC_STORAGE_BIT);
+
+	// The binding point never changes, so attach it once here
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, id);
+}
+
+///////////////////////////////////////////////////
+//	Update(const void*, GLsizeiptr, GLintptr)
+//
+//	Overwrite part of the buffer store
+///////////////////////////////////////////////////
+void UniformBuffer::Update(const void* data, GLsizeiptr byteSize, GLintptr offset)
+{
+	UpdateBuffer(id, offset, byteSize, data);
+}
+
+void UniformBuffer::Destroy()
+{
+	DeleteBuffer(id);
+	size = 0;
+}
@@ -0,0 +1,22 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformBuffer.h
+// ========
+// buffer object bound to a fixed uniform block binding point
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+class UniformBuffer
+{
+public:
+	GLuint id = 0;          // Handle for the buffer object
+	GLuint binding = 0;     // Uniform block binding point it is attached to
+	GLsizeiptr size = 0;    // Size of the buffer store in bytes
+
+public:
+	void Create(GLuint bindingPoint, GLsizeiptr byteSize, const void* data = nullptr);
+	void Update(const void* data, GLsizeiptr byteSize, GLintptr offset = 0);
+	void Destroy();
+};
@@ -0,0 +1,422 @@
+///////////////////////////////////////////////////////////////////////////////
+// blockCompression.cpp
+// ========
+// BC1, BC3 and BC7 encoders for 4x4 blocks of RGBA texels
+///////////////////////////////////////////////////////////////////////////////
+
+#include "blockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	const int BLOCK_TEXELS = 16;
+	const int POWER_ITERATIONS = 8;
+	const int REFINE_PASSES = 2;
+
+	// Position of each BC1 color index between endpoint 0 and endpoint 1
+	const float BC1_WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	// Weights of the BC7 4-bit indices, in 64ths
+	const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	float Clamp(float value, float low, float high)
+	{
+		return std::min(std::max(value, low), high);
+	}
+
+	///////////////////////////////////////////////////
+	//	PrincipalEndpoints(const unsigned char*, int, float*, float*)
+	//
+	//	channels: leading channels taken into account
+	//	low, high: receive the extremes of the texels
+	//	projected on their principal axis
+	//
+	//	The axis comes from power iteration on the
+	//	covariance matrix; a flat block gets its mean
+	//	as both endpoints
+	///////////////////////////////////////////////////
+	void PrincipalEndpoints(const unsigned char texels[64], int channels, float low[4], float high[4])
+	{
+		float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < BLOCK_TEXELS; ++i)
+			for (int c = 0; c < channels; ++c)
+				mean[c] += texels[i * 4 + c] / (float)BLOCK_TEXELS;
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < BLOCK_TEXELS; ++i)
+			for (int a = 0; a < channels; ++a)
+				for (int b = 0; b < channels; ++b)
+					covariance[a][b] += (texels[i * 4 + a] - mean[a]) * (texels[i * 4 + b] - mean[b]);
+
+		float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < POWER_ITERATIONS; ++iteration)
+		{
+			float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float length = 0.0f;
+			for (int a = 0; a < channels; ++a)
+			{
+				for (int b = 0; b < channels; ++b)
+					next[a] += covariance[a][b] * axis[b];
+				length += next[a] * next[a];
+			}
+
+			length = std::sqrt(length);
+			if (length < 1e-6f)
+				break;
+			for (int c = 0; c < channels; ++c)
+				axis[c] = next[c] / length;
+		}
+
+		float lowT = 0.0f;
+		float highT = 0.0f;
+		for (int i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < channels; ++c)
+				t += (texels[i * 4 + c] - mean[c]) * axis[c];
+			lowT = std::min(lowT, t);
+			highT = std::max(highT, t);
+		}
+
+		for (int c = 0; c < 4; ++c)
+		{
+			low[c] = c < channels ? Clamp(mean[c] + axis[c] * lowT, 0.0f, 255.0f) : 255.0f;
+			high[c] = c < channels ? Clamp(mean[c] + axis[c] * highT, 0.0f, 255.0f) : 255.0f;
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	LeastSquaresEndpoints(const unsigned char*, int, const float*, float*, float*)
+	//
+	//	weights: position of each texel between the
+	//	two endpoints, from its index
+	//	start, end: receive the endpoints that best
+	//	reproduce the texels at those positions
+	//
+	//	False when every texel sits on the same index
+	///////////////////////////////////////////////////
+	bool LeastSquaresEndpoints(const unsigned char texels[64], int channels, const float weights[16], float start[4], float end[4])
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			float b = weights[i];
+			float a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < channels; ++c)
+			{
+				ax[c] += a * texels[i * 4 + c];
+				bx[c] += b * texels[i * 4 + c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f)
+			return false;
+
+		for (int c = 0; c < 4; ++c)
+		{
+			start[c] = c < channels ? Clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f) : 255.0f;
+			end[c] = c < channels ? Clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f) : 255.0f;
+		}
+		return true;
+	}
+
+	// BC1 / BC3 color blocks /////////////////////////////////////////////////
+
+	uint16_t To565(const float color[4])
+	{
+		int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+		int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+		int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	void From565(uint16_t color, int rgb[3])
+	{
+		int r = color >> 11;
+		int g = (color >> 5) & 63;
+		int b = color & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	///////////////////////////////////////////////////
+	//	FitColorIndices(const unsigned char*, uint16_t&, uint16_t&, uint32_t&)
+	//
+	//	color0, color1: endpoints, put in the order that
+	//	selects the four-color palette
+	//	indices: receives the closest entry per texel
+	//
+	//	Returns the squared error of the block
+	///////////////////////////////////////////////////
+	int FitColorIndices(const unsigned char texels[64], uint16_t& color0, uint16_t& color1, uint32_t& indices)
+	{
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		int palette[4][3];
+		From565(color0, palette[0]);
+		From565(color1, palette[1]);
+		for (int c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		// Equal endpoints decode as a three-color block; index 0 is the same color either way
+		int entries = color0 == color1 ? 1 : 4;
+
+		indices = 0;
+		int error = 0;
+		for (int i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			int best = 0;
+			int bestError = INT32_MAX;
+			for (int entry = 0; entry < entries; ++entry)
+			{
+				int entryError = 0;
+				for (int c = 0; c < 3; ++c)
+				{
+					int difference = texels[i * 4 + c] - palette[entry][c];
+					entryError += difference * difference;
+				}
+				if (entryError < bestError)
+				{
+					best = entry;
+					bestError = entryError;
+				}
+			}
+			indices |= (uint32_t)best << (2 * i);
+			error += bestError;
+		}
+		return error;
+	}
+
+	void CompressColorBlock(const unsigned char texels[64], unsigned char* block)
+	{
+		float low[4], high[4];
+		PrincipalEndpoints(texels, 3, low, high);
+
+		uint16_t color0 = To565(high);
+		uint16_t color1 = To565(low);
+		uint32_t indices;
+		int error = FitColorIndices(texels, color0, color1, indices);
+
+		for (int pass = 0; pass < REFINE_PASSES && error > 0; ++pass)
+		{
+			float weights[16];
+			for (int i = 0; i < BLOCK_TEXELS; ++i)
+				weights[i] = BC1_WEIGHTS[(indices >> (2 * i)) & 3];
+
+			float start[4], end[4];
+			if (!LeastSquaresEndpoints(texels, 3, weights, start, end))
+				break;
+
+			uint16_t candidate0 = To565(start);
+			uint16_t candidate1 = To565(end);
+			uint32_t candidateIndices;
+			int candidateError = FitColorIndices(texels, candidate0, candidate1, candidateIndices);
+			if (candidateError >= error)
+				break;
+
+			color0 = candidate0;
+			color1 = candidate1;
+			indices = candidateIndices;
+			error = candidateError;
+		}
+
+		memcpy(block, &color0, 2);
+		memcpy(block + 2, &color1, 2);
+		memcpy(block + 4, &indices, 4);
+	}
+
+	// BC3 alpha blocks: two 8-bit endpoints and six values between them
+	void CompressAlphaBlock(const unsigned char texels[64], unsigned char* block)
+	{
+		int low = 255;
+		int high = 0;
+		for (int i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			low = std::min(low, (int)texels[i * 4 + 3]);
+			high = std::max(high, (int)texels[i * 4 + 3]);
+		}
+
+		int palette[8] = { high, low };
+		for (int entry = 2; entry < 8; ++entry)
+			palette[entry] = ((8 - entry) * high + (entry - 1) * low) / 7;
+
+		uint64_t indices = 0;
+		for (int i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			int best = 0;
+			for (int entry = 1; entry < 8; ++entry)
+				if (std::abs(texels[i * 4 + 3] - palette[entry]) < std::abs(texels[i * 4 + 3] - palette[best]))
+					best = entry;
+			indices |= (uint64_t)best << (3 * i);
+		}
+
+		block[0] = (unsigned char)high;
+		block[1] = (unsigned char)low;
+		for (int b = 0; b < 6; ++b)
+			block[2 + b] = (unsigned char)(indices >> (8 * b));
+	}
+
+	// BC7 mode 6 /////////////////////////////////////////////////////////////
+
+	// Packs fields into a block, least significant bit first
+	struct BitWriter
+	{
+		unsigned char* block;
+		int bit;
+
+		void Put(uint32_t value, int count)
+		{
+			for (int i = 0; i < count; ++i, ++bit)
+				if ((value >> i) & 1)
+					block[bit >> 3] |= (unsigned char)(1 << (bit & 7));
+		}
+	};
+
+	// Mode 6 endpoint: 7 bits per channel and a p-bit shared by the four
+	struct Bc7Endpoint
+	{
+		int channels[4];
+		int pBit;
+
+		int Expanded(int c) const { return (channels[c] << 1) | pBit; }
+	};
+
+	Bc7Endpoint QuantizeBc7Endpoint(const float value[4])
+	{
+		Bc7Endpoint best = {};
+		float bestError = 0.0f;
+		for (int pBit = 0; pBit < 2; ++pBit)
+		{
+			Bc7Endpoint endpoint;
+			endpoint.pBit = pBit;
+			float error = 0.0f;
+			for (int c = 0; c < 4; ++c)
+			{
+				endpoint.channels[c] = std::min(std::max((int)((value[c] - pBit) / 2.0f + 0.5f), 0), 127);
+				float difference = endpoint.Expanded(c) - value[c];
+				error += difference * difference;
+			}
+
+			if (pBit == 0 || error < bestError)
+			{
+				best = endpoint;
+				bestError = error;
+			}
+		}
+		return best;
+	}
+
+	// Closest of the 16 interpolated colors per texel; returns the squared error
+	int FitBc7Indices(const unsigned char texels[64], const Bc7Endpoint& start, const Bc7Endpoint& end, int indices[16])
+	{
+		int palette[16][4];
+		for (int entry = 0; entry < 16; ++entry)
+			for (int c = 0; c < 4; ++c)
+				palette[entry][c] = ((64 - BC7_WEIGHTS[entry]) * start.Expanded(c) + BC7_WEIGHTS[entry] * end.Expanded(c) + 32) >> 6;
+
+		int error = 0;
+		for (int i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			int bestError = INT32_MAX;
+			for (int entry = 0; entry < 16; ++entry)
+			{
+				int entryError = 0;
+				for (int c = 0; c < 4; ++c)
+				{
+					int difference = texels[i * 4 + c] - palette[entry][c];
+					entryError += difference * difference;
+				}
+				if (entryError < bestError)
+				{
+					indices[i] = entry;
+					bestError = entryError;
+				}
+			}
+			error += bestError;
+		}
+		return error;
+	}
+}
+
+void CompressBlockBC1(const unsigned char texels[64], unsigned char* block)
+{
+	CompressColorBlock(texels, block);
+}
+
+void CompressBlockBC3(const unsigned char texels[64], unsigned char* block)
+{
+	CompressAlphaBlock(texels, block);
+	CompressColorBlock(texels, block + 8);
+}
+
+void CompressBlockBC7(const unsigned char texels[64], unsigned char* block)
+{
+	float low[4], high[4];
+	PrincipalEndpoints(texels, 4, low, high);
+
+	Bc7Endpoint start = QuantizeBc7Endpoint(low);
+	Bc7Endpoint end = QuantizeBc7Endpoint(high);
+	int indices[16];
+	int error = FitBc7Indices(texels, start, end, indices);
+
+	for (int pass = 0; pass < REFINE_PASSES && error > 0; ++pass)
+	{
+		float weights[16];
+		for (int i = 0; i < BLOCK_TEXELS; ++i)
+			weights[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+
+		float fitStart[4], fitEnd[4];
+		if (!LeastSquaresEndpoints(texels, 4, weights, fitStart, fitEnd))
+			break;
+
+		Bc7Endpoint candidateStart = QuantizeBc7Endpoint(fitStart);
+		Bc7Endpoint candidateEnd = QuantizeBc7Endpoint(fitEnd);
+		int candidateIndices[16];
+		int candidateError = FitBc7Indices(texels, candidateStart, candidateEnd, candidateIndices);
+		if (candidateError >= error)
+			break;
+
+		start = candidateStart;
+		end = candidateEnd;
+		memcpy(indices, candidateIndices, sizeof(indices));
+		error = candidateError;
+	}
+
+	// The first texel's index is stored without its top bit, so it must be below 8
+	if (indices[0] >= 8)
+	{
+		std::swap(start, end);
+		for (int i = 0; i < BLOCK_TEXELS; ++i)
+			indices[i] = 15 - indices[i];
+	}
+
+	memset(block, 0, BC7_BLOCK_BYTES);
+	BitWriter writer = { block, 0 };
+	writer.Put(1 << 6, 7);                          // Mode 6
+	for (int c = 0; c < 4; ++c)
+	{
+		writer.Put(start.channels[c], 7);
+		writer.Put(end.channels[c], 7);
+	}
+	writer.Put(start.pBit, 1);
+	writer.Put(end.pBit, 1);
+
+	writer.Put(indices[0], 3);
+	for (int i = 1; i < BLOCK_TEXELS; ++i)
+		writer.Put(indices[i], 4);
+}
@@ -0,0 +1,22 @@
+///////////////////////////////////////////////////////////////////////////////
+// blockCompression.h
+// ========
+// BC1, BC3 and BC7 encoders for 4x4 blocks of RGBA texels
+//
+// Each encoder takes the 16 texels of a block row by row, 4 bytes each,
+// and writes one block in the layout glCompressedTexSubImage2D expects.
+// Endpoints come from the principal axis of the block's colors and are
+// then refined by a least-squares fit to the chosen indices. BC7 always
+// uses mode 6: one subset, 7.7.7.7 endpoints with a p-bit and 4-bit
+// indices, which covers opaque and transparent blocks alike.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+const int BC1_BLOCK_BYTES = 8;
+const int BC3_BLOCK_BYTES = 16;
+const int BC7_BLOCK_BYTES = 16;
+
+void CompressBlockBC1(const unsigned char texels[64], unsigned char* block);     // Alpha ignored
+void CompressBlockBC3(const unsigned char texels[64], unsigned char* block);
+void CompressBlockBC7(const unsigned char texels[64], unsigned char* block);
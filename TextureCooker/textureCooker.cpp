@@ -0,0 +1,247 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureCooker.cpp
+// ========
+// offline conversion of the scene's images into block-compressed KTX2 files
+//
+// Every image is decoded, flipped to GL's bottom-up row order, optionally
+// scaled to a square size, reduced to a full mip chain with a 2x2 box
+// filter, and compressed level by level
+// into a KTX2 file next to it (marble.jpg -> marble.ktx2), which the
+// renderer then loads instead of the image. With --format auto, opaque
+// images become BC1 and images with any transparency BC3; BC7 trades a
+// slower cook for better quality at BC3's size. The renderer keeps its
+// textures as layers of array textures, one per format and size, so
+// cooking every image at one --size lets them share a single array.
+//
+// Usage:
+//	TextureCooker [--format auto|bc1|bc3|bc7] [--size N] image...
+//
+// The build runs it over resources/textures after linking, at the size the
+// renderer scales its decoded textures to.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb-master/stb_image.h>
+
+#include "blockCompression.h"
+#include "compressedTexture.h"
+#include "imageUtils.h"
+
+using namespace std;
+
+namespace
+{
+	enum Format { FORMAT_AUTO, FORMAT_BC1, FORMAT_BC3, FORMAT_BC7 };
+
+	typedef void (*BlockCompressor)(const unsigned char texels[64], unsigned char* block);
+
+	// One mip level of RGBA texels
+	struct Image
+	{
+		int width;
+		int height;
+		vector<unsigned char> texels;
+	};
+
+	bool IsOpaque(const Image& image)
+	{
+		for (size_t i = 3; i < image.texels.size(); i += 4)
+			if (image.texels[i] != 255)
+				return false;
+		return true;
+	}
+
+	Image Downsample(const Image& image)
+	{
+		Image half;
+		half.width = max(1, image.width / 2);
+		half.height = max(1, image.height / 2);
+		half.texels.resize((size_t)half.width * half.height * 4);
+		downsampleImage(image.texels.data(), image.width, image.height, 4, half.texels.data());
+		return half;
+	}
+
+	// Compress one level, 4x4 blocks in rows; edge blocks of odd sizes repeat the last texels
+	void CompressLevel(const Image& image, BlockCompressor compress, GLsizei blockBytes, vector<unsigned char>& out)
+	{
+		unsigned char texels[64];
+		for (int blockY = 0; blockY < image.height; blockY += 4)
+		{
+			for (int blockX = 0; blockX < image.width; blockX += 4)
+			{
+				for (int y = 0; y < 4; ++y)
+				{
+					int sourceY = min(blockY + y, image.height - 1);
+					for (int x = 0; x < 4; ++x)
+					{
+						int sourceX = min(blockX + x, image.width - 1);
+						memcpy(texels + (y * 4 + x) * 4, &image.texels[((size_t)sourceY * image.width + sourceX) * 4], 4);
+					}
+				}
+
+				size_t offset = out.size();
+				out.resize(offset + blockBytes);
+				compress(texels, &out[offset]);
+			}
+		}
+	}
+
+	const char* FormatName(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			return "BC1";
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			return "BC3";
+		default:
+			return "BC7";
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	CookTexture(const char*, Format, int)
+	//
+	//	imagePath: any image stb_image can decode
+	//	format: block format, or FORMAT_AUTO to pick
+	//	one from the image's alpha
+	//	size: width and height of level 0, or 0 to
+	//	keep the image's own
+	//
+	//	Write the image's cooked KTX2 file
+	///////////////////////////////////////////////////
+	bool CookTexture(const char* imagePath, Format format, int size)
+	{
+		Image image;
+		int channels;
+		stbi_set_flip_vertically_on_load(1);
+		unsigned char* pixels = stbi_load(imagePath, &image.width, &image.height, &channels, 4);
+		if (!pixels)
+		{
+			cerr << "ERROR::TEXTURE_COOKER::CANNOT_DECODE " << imagePath << endl;
+			return false;
+		}
+		image.texels.assign(pixels, pixels + (size_t)image.width * image.height * 4);
+		stbi_image_free(pixels);
+
+		if (size > 0 && (image.width != size || image.height != size))
+		{
+			Image scaled;
+			scaled.width = size;
+			scaled.height = size;
+			scaled.texels.resize((size_t)size * size * 4);
+			resampleImage(image.texels.data(), image.width, image.height, 4, scaled.texels.data(), size, size);
+			image = move(scaled);
+		}
+
+		if (format == FORMAT_AUTO)
+			format = IsOpaque(image) ? FORMAT_BC1 : FORMAT_BC3;
+
+		BlockCompressor compress = CompressBlockBC7;
+		CompressedTexture texture;
+		texture.internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+		if (format == FORMAT_BC1)
+		{
+			compress = CompressBlockBC1;
+			texture.internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		}
+		else if (format == FORMAT_BC3)
+		{
+			compress = CompressBlockBC3;
+			texture.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		}
+		texture.width = image.width;
+		texture.height = image.height;
+
+		GLsizei blockBytes = CompressedBlockBytes(texture.internalFormat);
+		while (true)
+		{
+			size_t offset = texture.data.size();
+			CompressLevel(image, compress, blockBytes, texture.data);
+			texture.levels.push_back({ offset, texture.data.size() - offset });
+
+			if (image.width == 1 && image.height == 1)
+				break;
+			image = Downsample(image);
+		}
+
+		string cookedPath = CookedTexturePath(imagePath);
+		if (!WriteKtx2(cookedPath.c_str(), texture))
+			return false;
+
+		// Drivers keep GL_RGB8 padded to four bytes a texel, like GL_RGBA8
+		size_t uncompressedBytes = 0;
+		for (size_t level = 0; level < texture.levels.size(); ++level)
+			uncompressedBytes += (size_t)max(1, texture.width >> level) * max(1, texture.height >> level) * 4;
+
+		cout << imagePath << " -> " << cookedPath << ": " << FormatName(texture.internalFormat) << " "
+			<< texture.width << "x" << texture.height << ", " << texture.levels.size() << " levels, "
+			<< texture.data.size() / 1024 << " KB (" << fixed << setprecision(1) << (double)uncompressedBytes / texture.data.size()
+			<< "x smaller than RGBA8)" << endl;
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Format format = FORMAT_AUTO;
+	int size = 0;
+	vector<const char*> images;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+		{
+			const char* name = argv[++i];
+			if (strcmp(name, "auto") == 0)
+				format = FORMAT_AUTO;
+			else if (strcmp(name, "bc1") == 0)
+				format = FORMAT_BC1;
+			else if (strcmp(name, "bc3") == 0)
+				format = FORMAT_BC3;
+			else if (strcmp(name, "bc7") == 0)
+				format = FORMAT_BC7;
+			else
+			{
+				cerr << "Unknown format " << name << endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+		{
+			size = atoi(argv[++i]);
+			if (size <= 0)
+			{
+				cerr << "Invalid size " << argv[i] << endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strncmp(argv[i], "--", 2) == 0)
+		{
+			cerr << "Unknown argument " << argv[i] << endl;
+			return EXIT_FAILURE;
+		}
+		else
+			images.push_back(argv[i]);
+	}
+
+	if (images.empty())
+	{
+		cerr << "Usage: TextureCooker [--format auto|bc1|bc3|bc7] [--size N] image..." << endl;
+		return EXIT_FAILURE;
+	}
+
+	bool cooked = true;
+	for (const char* image : images)
+		cooked = CookTexture(image, format, size) && cooked;
+
+	return cooked ? EXIT_SUCCESS : EXIT_FAILURE;
+}